@@ -0,0 +1,97 @@
+// arena.c - Reserva de memoria por avance de puntero
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16
+
+struct ArenaBlock {
+    ArenaBlock *prev;
+    size_t size;             // Bytes útiles en 'data'
+    size_t pos;              // Siguiente byte libre
+    _Alignas(ARENA_ALIGN) unsigned char data[];
+};
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static ArenaBlock *block_new(size_t size, ArenaBlock *prev) {
+    ArenaBlock *blk = malloc(sizeof(ArenaBlock) + size);
+    if (!blk) { perror("malloc"); exit(EXIT_FAILURE); }
+    blk->prev = prev;
+    blk->size = size;
+    blk->pos = 0;
+    return blk;
+}
+
+void arena_init(Arena *a, size_t block_size) {
+    a->head = NULL;
+    a->block_size = block_size ? align_up(block_size) : 64 * 1024;
+    a->used_total = 0;
+    a->last = NULL;
+}
+
+void *arena_alloc(Arena *a, size_t size) {
+    size = align_up(size ? size : 1);
+
+    if (!a->head || a->head->size - a->head->pos < size) {
+        size_t blk_size = size > a->block_size ? size : a->block_size;
+        a->head = block_new(blk_size, a->head);
+    }
+
+    void *p = a->head->data + a->head->pos;
+    a->head->pos += size;
+    a->used_total += size;
+    a->last = p;
+    return p;
+}
+
+void *arena_realloc(Arena *a, void *ptr, size_t old_size, size_t new_size) {
+    if (!ptr) return arena_alloc(a, new_size);
+    if (new_size <= old_size) return ptr;
+
+    // La última reserva crece sin copiarse si queda lugar en el bloque
+    if (ptr == a->last) {
+        ArenaBlock *blk = a->head;
+        size_t start = (size_t)((unsigned char *)ptr - blk->data);
+        size_t need = align_up(new_size);
+        if (start + need <= blk->size) {
+            a->used_total += need - (blk->pos - start);
+            blk->pos = start + need;
+            return ptr;
+        }
+    }
+
+    void *p = arena_alloc(a, new_size);
+    memcpy(p, ptr, old_size);
+    return p;
+}
+
+void arena_reset(Arena *a) {
+    if (!a->head) return;
+
+    if (a->head->prev) {
+        // Varios bloques: se reemplazan por uno que alcance para todo
+        size_t total = a->used_total > a->block_size ? a->used_total : a->block_size;
+        arena_free(a);
+        a->head = block_new(align_up(total), NULL);
+    }
+
+    a->head->pos = 0;
+    a->used_total = 0;
+    a->last = NULL;
+}
+
+void arena_free(Arena *a) {
+    ArenaBlock *blk = a->head;
+    while (blk) {
+        ArenaBlock *prev = blk->prev;
+        free(blk);
+        blk = prev;
+    }
+    a->head = NULL;
+    a->used_total = 0;
+    a->last = NULL;
+}
@@ -0,0 +1,37 @@
+// arena.h - Reserva de memoria por avance de puntero (bump allocator)
+//
+// Las reservas se toman de bloques grandes y no se liberan una a una: al
+// terminar una partida arena_reset descarta todo de una vez y deja la
+// memoria lista para la siguiente. Cada hilo usa su propia arena.
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock *head;        // Bloque actual (los anteriores quedan enlazados)
+    size_t block_size;       // Tamaño mínimo de cada bloque nuevo
+    size_t used_total;       // Bytes reservados desde el último reset
+    void *last;              // Última reserva (puede crecer en su lugar)
+} Arena;
+
+// Inicializa la arena sin reservar memoria todavía
+void arena_init(Arena *a, size_t block_size);
+
+// Reserva 'size' bytes alineados a 16. Sale del programa si no hay memoria
+void *arena_alloc(Arena *a, size_t size);
+
+// Agranda una reserva de la arena. Si es la última y cabe en el bloque,
+// crece en su lugar; si no, se copia a una reserva nueva
+void *arena_realloc(Arena *a, void *ptr, size_t old_size, size_t new_size);
+
+// Descarta todas las reservas. Si se usaron varios bloques, los reemplaza
+// por uno solo del tamaño total, así la siguiente partida no reserva más
+void arena_reset(Arena *a);
+
+// Libera todos los bloques
+void arena_free(Arena *a);
+
+#endif // ARENA_H
@@ -0,0 +1,234 @@
+// attacks.c - Construcción de las tablas de ataque
+#include <pthread.h>
+#include "attacks.h"
+
+Bitboard knight_attack_table[64];
+Bitboard king_attack_table[64];
+Bitboard pawn_attack_table[2][64];
+Magic rook_magics[64];
+Magic bishop_magics[64];
+Bitboard between_table[64][64];
+Bitboard line_table[64][64];
+
+// Tamaño total de las subtablas (suma de 2^bits relevantes por casilla)
+#define ROOK_TABLE_SIZE   102400
+#define BISHOP_TABLE_SIZE 5248
+
+static Bitboard rook_table[ROOK_TABLE_SIZE];
+static Bitboard bishop_table[BISHOP_TABLE_SIZE];
+
+static pthread_once_t attacks_once = PTHREAD_ONCE_INIT;
+
+static const int rook_dirs[4][2]   = { { 1, 0}, {-1, 0}, { 0, 1}, { 0,-1} };
+static const int bishop_dirs[4][2] = { { 1, 1}, { 1,-1}, {-1, 1}, {-1,-1} };
+
+// Recorre los 4 rayos desde sq hasta el borde o la primera pieza (incluida)
+static Bitboard slider_attacks_slow(int sq, Bitboard occupied, const int dirs[4][2])
+{
+    Bitboard result = 0;
+    int r0 = sq / 8, f0 = sq % 8;
+
+    for (int d = 0; d < 4; ++d) {
+        int r = r0 + dirs[d][0];
+        int f = f0 + dirs[d][1];
+        while (r >= 0 && r < 8 && f >= 0 && f < 8) {
+            Bitboard bit = (Bitboard)1 << (r * 8 + f);
+            result |= bit;
+            if (occupied & bit) break;
+            r += dirs[d][0];
+            f += dirs[d][1];
+        }
+    }
+    return result;
+}
+
+Bitboard rook_attacks_slow(int sq, Bitboard occupied) {
+    return slider_attacks_slow(sq, occupied, rook_dirs);
+}
+
+Bitboard bishop_attacks_slow(int sq, Bitboard occupied) {
+    return slider_attacks_slow(sq, occupied, bishop_dirs);
+}
+
+// Máscara de casillas relevantes: el rayo sin la última casilla del borde
+static Bitboard slider_mask(int sq, const int dirs[4][2])
+{
+    Bitboard result = 0;
+    int r0 = sq / 8, f0 = sq % 8;
+
+    for (int d = 0; d < 4; ++d) {
+        int r = r0 + dirs[d][0];
+        int f = f0 + dirs[d][1];
+        while (r + dirs[d][0] >= 0 && r + dirs[d][0] < 8 &&
+               f + dirs[d][1] >= 0 && f + dirs[d][1] < 8) {
+            result |= (Bitboard)1 << (r * 8 + f);
+            r += dirs[d][0];
+            f += dirs[d][1];
+        }
+    }
+    return result;
+}
+
+// Tabla de saltos (caballo/rey) a partir de una lista de desplazamientos
+static Bitboard leaper_attacks(int sq, const int offsets[8][2])
+{
+    Bitboard result = 0;
+    int r0 = sq / 8, f0 = sq % 8;
+
+    for (int k = 0; k < 8; ++k) {
+        int r = r0 + offsets[k][0];
+        int f = f0 + offsets[k][1];
+        if (r < 0 || r >= 8 || f < 0 || f >= 8) continue;
+        result |= (Bitboard)1 << (r * 8 + f);
+    }
+    return result;
+}
+
+// Números mágicos por casilla. Se obtuvieron con la búsqueda aleatoria
+// habitual (candidatos xorshift64* dispersos, sembrados por fila, hasta
+// que ningún par de ocupaciones con ataques distintos colisiona); tenerlos
+// fijos evita repetir esa búsqueda en cada arranque.
+static const Bitboard rook_magic_numbers[64] = {
+    0x0A80004000801220ULL, 0x8040004010002008ULL, 0x2080200010008008ULL,
+    0x1100100008210004ULL, 0xC200209084020008ULL, 0x2100010004000208ULL,
+    0x0400081000822421ULL, 0x0200010422048844ULL, 0x0800800080400024ULL,
+    0x0001402000401000ULL, 0x3000801000802001ULL, 0x4400800800100083ULL,
+    0x0904802402480080ULL, 0x4040800400020080ULL, 0x0018808042000100ULL,
+    0x4040800080004100ULL, 0x0040048001458024ULL, 0x00A0004000205000ULL,
+    0x3100808010002000ULL, 0x4825010010000820ULL, 0x5004808008000401ULL,
+    0x2024818004000A00ULL, 0x0005808002000100ULL, 0x2100060004806104ULL,
+    0x0080400880008421ULL, 0x4062220600410280ULL, 0x010A004A00108022ULL,
+    0x0000100080080080ULL, 0x0021000500080010ULL, 0x0044000202001008ULL,
+    0x0000100400080102ULL, 0xC020128200040545ULL, 0x0080002000400040ULL,
+    0x0000804000802004ULL, 0x0000120022004080ULL, 0x010A386103001001ULL,
+    0x9010080080800400ULL, 0x8440020080800400ULL, 0x0004228824001001ULL,
+    0x000000490A000084ULL, 0x0080002000504000ULL, 0x200020005000C000ULL,
+    0x0012088020420010ULL, 0x0010010080080800ULL, 0x0085001008010004ULL,
+    0x0002000204008080ULL, 0x0040413002040008ULL, 0x0000304081020004ULL,
+    0x0080204000800080ULL, 0x3008804000290100ULL, 0x1010100080200080ULL,
+    0x2008100208028080ULL, 0x5000850800910100ULL, 0x8402019004680200ULL,
+    0x0120911028020400ULL, 0x0000008044010200ULL, 0x0020850200244012ULL,
+    0x0020850200244012ULL, 0x0000102001040841ULL, 0x140900040A100021ULL,
+    0x000200282410A102ULL, 0x000200282410A102ULL, 0x000200282410A102ULL,
+    0x4048240043802106ULL,
+};
+
+static const Bitboard bishop_magic_numbers[64] = {
+    0x40106000A1160020ULL, 0x0020010250810120ULL, 0x2010010220280081ULL,
+    0x002806004050C040ULL, 0x0002021018000000ULL, 0x2001112010000400ULL,
+    0x0881010120218080ULL, 0x1030820110010500ULL, 0x0000120222042400ULL,
+    0x2000020404040044ULL, 0x8000480094208000ULL, 0x0003422A02000001ULL,
+    0x000A220210100040ULL, 0x8004820202226000ULL, 0x0018234854100800ULL,
+    0x0100004042101040ULL, 0x0004001004082820ULL, 0x0010000810010048ULL,
+    0x1014004208081300ULL, 0x2080818802044202ULL, 0x0040880C00A00100ULL,
+    0x0080400200522010ULL, 0x0001000188180B04ULL, 0x0080249202020204ULL,
+    0x1004400004100410ULL, 0x00013100A0022206ULL, 0x2148500001040080ULL,
+    0x4241080011004300ULL, 0x4020848004002000ULL, 0x10101380D1004100ULL,
+    0x0008004422020284ULL, 0x01010A1041008080ULL, 0x0808080400082121ULL,
+    0x0808080400082121ULL, 0x0091128200100C00ULL, 0x0202200802010104ULL,
+    0x8C0A020200440085ULL, 0x01A0008080B10040ULL, 0x0889520080122800ULL,
+    0x100902022202010AULL, 0x04081A0816002000ULL, 0x0000681208005000ULL,
+    0x8170840041008802ULL, 0x0A00004200810805ULL, 0x0830404408210100ULL,
+    0x2602208106006102ULL, 0x1048300680802628ULL, 0x2602208106006102ULL,
+    0x0602010120110040ULL, 0x0941010801043000ULL, 0x000040440A210428ULL,
+    0x0008240020880021ULL, 0x0400002012048200ULL, 0x00AC102001210220ULL,
+    0x0220021002009900ULL, 0x84440C080A013080ULL, 0x0001008044200440ULL,
+    0x0004C04410841000ULL, 0x2000500104011130ULL, 0x1A0C010011C20229ULL,
+    0x0044800112202200ULL, 0x0434804908100424ULL, 0x0300404822C08200ULL,
+    0x48081010008A2A80ULL,
+};
+
+// Llena la tabla de una casilla; devuelve cuántas entradas usa
+static size_t init_slider_square(Magic *m, int sq, Bitboard *table,
+                                 Bitboard magic, const int dirs[4][2])
+{
+    m->mask = slider_mask(sq, dirs);
+    int bits = __builtin_popcountll(m->mask);
+    size_t size = (size_t)1 << bits;
+    m->shift = 64 - bits;
+    m->attacks = table;
+
+    // Con PEXT el índice es directamente la ocupación comprimida
+#ifdef __BMI2__
+    (void)magic;
+    m->magic = 0;
+#else
+    m->magic = magic;
+#endif
+
+    // Enumera todos los subconjuntos de la máscara (carry-rippler)
+    Bitboard subset = 0;
+    do {
+        table[magic_index(m, subset)] = slider_attacks_slow(sq, subset, dirs);
+        subset = (subset - m->mask) & m->mask;
+    } while (subset);
+
+    return size;
+}
+
+static void attacks_build(void)
+{
+    static const int knight_offsets[8][2] = {
+        { 2, 1}, { 2,-1}, {-2, 1}, {-2,-1},
+        { 1, 2}, { 1,-2}, {-1, 2}, {-1,-2}
+    };
+    static const int king_offsets[8][2] = {
+        { 1, 0}, {-1, 0}, { 0, 1}, { 0,-1},
+        { 1, 1}, { 1,-1}, {-1, 1}, {-1,-1}
+    };
+
+    for (int sq = 0; sq < 64; ++sq) {
+        int r = sq / 8, f = sq % 8;
+
+        knight_attack_table[sq] = leaper_attacks(sq, knight_offsets);
+        king_attack_table[sq]   = leaper_attacks(sq, king_offsets);
+
+        // Peón blanco ataca (r+1, f±1); peón negro ataca (r-1, f±1)
+        Bitboard w = 0, b = 0;
+        if (r + 1 < 8) {
+            if (f - 1 >= 0) w |= (Bitboard)1 << ((r + 1) * 8 + f - 1);
+            if (f + 1 < 8)  w |= (Bitboard)1 << ((r + 1) * 8 + f + 1);
+        }
+        if (r - 1 >= 0) {
+            if (f - 1 >= 0) b |= (Bitboard)1 << ((r - 1) * 8 + f - 1);
+            if (f + 1 < 8)  b |= (Bitboard)1 << ((r - 1) * 8 + f + 1);
+        }
+        pawn_attack_table[COLOR_WHITE - 1][sq] = w;
+        pawn_attack_table[COLOR_BLACK - 1][sq] = b;
+    }
+
+    size_t rook_used = 0, bishop_used = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        rook_used   += init_slider_square(&rook_magics[sq], sq,
+                                          rook_table + rook_used,
+                                          rook_magic_numbers[sq], rook_dirs);
+        bishop_used += init_slider_square(&bishop_magics[sq], sq,
+                                          bishop_table + bishop_used,
+                                          bishop_magic_numbers[sq], bishop_dirs);
+    }
+
+    // Segmentos y líneas entre pares de casillas alineadas
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            Bitboard bit_a = (Bitboard)1 << a, bit_b = (Bitboard)1 << b;
+            between_table[a][b] = 0;
+            line_table[a][b] = 0;
+            if (a == b) continue;
+
+            if (rook_attacks_slow(a, 0) & bit_b) {
+                line_table[a][b] = (rook_attacks_slow(a, 0) & rook_attacks_slow(b, 0))
+                                   | bit_a | bit_b;
+                between_table[a][b] = rook_attacks_slow(a, bit_b) & rook_attacks_slow(b, bit_a);
+            } else if (bishop_attacks_slow(a, 0) & bit_b) {
+                line_table[a][b] = (bishop_attacks_slow(a, 0) & bishop_attacks_slow(b, 0))
+                                   | bit_a | bit_b;
+                between_table[a][b] = bishop_attacks_slow(a, bit_b) & bishop_attacks_slow(b, bit_a);
+            }
+        }
+    }
+}
+
+void attacks_init(void)
+{
+    pthread_once(&attacks_once, attacks_build);
+}
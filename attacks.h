@@ -0,0 +1,85 @@
+// attacks.h - Tablas de ataque precalculadas (caballo, rey, peón) y
+// consultas de piezas deslizantes con magic bitboards (o PEXT si hay BMI2)
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include "semant.h"
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// Entrada de la tabla mágica de una casilla
+typedef struct {
+    Bitboard mask;       // Casillas relevantes (sin bordes) para la pieza
+    Bitboard magic;      // Multiplicador mágico (sin uso con PEXT)
+    Bitboard *attacks;   // Subtabla de ataques de esta casilla
+    unsigned shift;      // 64 - bits relevantes
+} Magic;
+
+extern Bitboard knight_attack_table[64];
+extern Bitboard king_attack_table[64];
+extern Bitboard pawn_attack_table[2][64];   // [color - 1][casilla]
+extern Magic rook_magics[64];
+extern Magic bishop_magics[64];
+
+// Casillas estrictamente entre a y b si están en la misma fila, columna
+// o diagonal; 0 si no están alineadas
+extern Bitboard between_table[64][64];
+// Línea completa (de borde a borde) que pasa por a y b; 0 si no están alineadas
+extern Bitboard line_table[64][64];
+
+// Inicializa todas las tablas. Es idempotente y segura entre hilos (solo la
+// primera llamada las construye); los constructores de Board la llaman
+// antes de que exista cualquier posición.
+void attacks_init(void);
+
+// Ataques calculados recorriendo rayos casilla por casilla (lento).
+// Se usan para construir las tablas y como referencia.
+Bitboard rook_attacks_slow(int sq, Bitboard occupied);
+Bitboard bishop_attacks_slow(int sq, Bitboard occupied);
+
+static inline unsigned magic_index(const Magic *m, Bitboard occupied) {
+#ifdef __BMI2__
+    return (unsigned)_pext_u64(occupied, m->mask);
+#else
+    return (unsigned)(((occupied & m->mask) * m->magic) >> m->shift);
+#endif
+}
+
+static inline Bitboard knight_attacks(int sq) {
+    return knight_attack_table[sq];
+}
+
+static inline Bitboard king_attacks(int sq) {
+    return king_attack_table[sq];
+}
+
+// Casillas que ataca un peón de color 'c' situado en sq
+static inline Bitboard pawn_attacks(Color c, int sq) {
+    return pawn_attack_table[c - 1][sq];
+}
+
+static inline Bitboard rook_attacks(int sq, Bitboard occupied) {
+    const Magic *m = &rook_magics[sq];
+    return m->attacks[magic_index(m, occupied)];
+}
+
+static inline Bitboard bishop_attacks(int sq, Bitboard occupied) {
+    const Magic *m = &bishop_magics[sq];
+    return m->attacks[magic_index(m, occupied)];
+}
+
+static inline Bitboard between(int a, int b) {
+    return between_table[a][b];
+}
+
+static inline Bitboard line_through(int a, int b) {
+    return line_table[a][b];
+}
+
+static inline Bitboard queen_attacks(int sq, Bitboard occupied) {
+    return rook_attacks(sq, occupied) | bishop_attacks(sq, occupied);
+}
+
+#endif // ATTACKS_H
@@ -0,0 +1,212 @@
+// bench_attacks.c - Micro-benchmark de is_square_attacked
+//
+// Compara la consulta con tablas precalculadas (board_is_square_attacked)
+// contra el recorrido de rayos casilla por casilla que usaba semant.c,
+// sobre todas las posiciones de las partidas de un archivo PGN.
+//
+// Compilar:
+//   gcc -O2 -o bench_attacks bench_attacks.c attacks.c zobrist.c lexer.c parser.c semant.c status_cache.c -pthread
+// Ejecutar:
+//   ./bench_attacks partida2.pgn [rondas]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "ast.h"
+#include "lexer.h"
+#include "parser.h"
+#include "semant.h"
+
+// Implementación anterior: recorre rayos y desplazamientos con
+// comprobación de límites en cada paso
+static int attacked_raywalk(const Board *b, int r, int f, Color enemy)
+{
+    // 1) Ataques de peones
+    int pr = (enemy == COLOR_WHITE) ? r - 1 : r + 1;
+    if (pr >= 0 && pr < 8) {
+        for (int df = -1; df <= 1; df += 2) {
+            Piece p = board_piece_at(b, pr, f + df);
+            if (p.color == enemy && p.type == PIECE_PAWN) return 1;
+        }
+    }
+
+    // 2) Ataques de caballos
+    const int knight_moves[8][2] = {
+        { 2, 1}, { 2,-1}, {-2, 1}, {-2,-1},
+        { 1, 2}, { 1,-2}, {-1, 2}, {-1,-2}
+    };
+    for (int k = 0; k < 8; ++k) {
+        int rr = r + knight_moves[k][0];
+        int ff = f + knight_moves[k][1];
+        if (rr < 0 || rr >= 8 || ff < 0 || ff >= 8) continue;
+        Piece p = board_piece_at(b, rr, ff);
+        if (p.color == enemy && p.type == PIECE_KNIGHT) return 1;
+    }
+
+    // 3) y 4) Líneas rectas y diagonales
+    const int dirs[8][2] = {
+        { 1, 0}, {-1, 0}, { 0, 1}, { 0,-1},
+        { 1, 1}, { 1,-1}, {-1, 1}, {-1,-1}
+    };
+    for (int d = 0; d < 8; ++d) {
+        PieceType slider = (d < 4) ? PIECE_ROOK : PIECE_BISHOP;
+        int rr = r + dirs[d][0];
+        int ff = f + dirs[d][1];
+        while (rr >= 0 && rr < 8 && ff >= 0 && ff < 8) {
+            Piece p = board_piece_at(b, rr, ff);
+            if (p.type != PIECE_NONE) {
+                if (p.color == enemy &&
+                    (p.type == slider || p.type == PIECE_QUEEN)) return 1;
+                break;
+            }
+            rr += dirs[d][0];
+            ff += dirs[d][1];
+        }
+    }
+
+    // 5) Ataques del rey enemigo
+    for (int dr = -1; dr <= 1; ++dr) {
+        for (int df = -1; df <= 1; ++df) {
+            if (dr == 0 && df == 0) continue;
+            int rr = r + dr, ff = f + df;
+            if (rr < 0 || rr >= 8 || ff < 0 || ff >= 8) continue;
+            Piece p = board_piece_at(b, rr, ff);
+            if (p.color == enemy && p.type == PIECE_KING) return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Ignora números de jugada ("12." / "12...") y resultados
+static int is_skippable(const char *tok) {
+    if (strcmp(tok, "1-0") == 0 || strcmp(tok, "0-1") == 0 ||
+        strcmp(tok, "1/2-1/2") == 0 || strcmp(tok, "*") == 0) return 1;
+    const char *p = tok;
+    while (isdigit((unsigned char)*p)) p++;
+    return p != tok && *p == '.';
+}
+
+// Reproduce las partidas del archivo y guarda cada posición alcanzada
+static Board *collect_positions(const char *path, size_t *out_count)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "No se puede abrir archivo PGN: %s\n", path);
+        return NULL;
+    }
+
+    size_t cap = 1024, count = 0;
+    Board *positions = malloc(sizeof(Board) * cap);
+    Board board;
+    Color side = COLOR_WHITE;
+    int game_ok = 0;
+    char line[4096];
+
+    while (positions && fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "[Event ", 7) == 0) {
+            board_init_start(&board);
+            side = COLOR_WHITE;
+            game_ok = 1;
+            continue;
+        }
+        if (line[0] == '[' || !game_ok) continue;
+
+        for (char *tok = strtok(line, " \t\r\n"); tok && game_ok;
+             tok = strtok(NULL, " \t\r\n")) {
+            if (is_skippable(tok)) continue;
+
+            TokenList tl;
+            MoveAST ast;
+            char err[256];
+            if (tokenize(tok, &tl) != 0) { game_ok = 0; break; }
+            if (parse_move(&tl, &ast) != 0 ||
+                board_apply_move(&board, &ast, side, err, sizeof(err)) != 0) {
+                game_ok = 0;
+            }
+            tokenlist_free(&tl);
+            if (!game_ok) break;
+
+            if (count == cap) {
+                cap *= 2;
+                Board *tmp = realloc(positions, sizeof(Board) * cap);
+                if (!tmp) { free(positions); positions = NULL; break; }
+                positions = tmp;
+            }
+            positions[count++] = board;
+            side = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+        }
+    }
+
+    fclose(f);
+    *out_count = count;
+    return positions;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = (argc >= 2) ? argv[1] : "partida2.pgn";
+    int rounds = (argc >= 3) ? atoi(argv[2]) : 3;
+    if (rounds <= 0) rounds = 1;
+
+    size_t count = 0;
+    Board *positions = collect_positions(path, &count);
+    if (!positions || count == 0) {
+        fprintf(stderr, "No se obtuvieron posiciones de %s\n", path);
+        free(positions);
+        return 1;
+    }
+
+    // Verificar que ambas implementaciones coinciden en todas las consultas
+    size_t mismatches = 0;
+    for (size_t i = 0; i < count; ++i) {
+        for (int sq = 0; sq < 64; ++sq) {
+            for (Color c = COLOR_WHITE; c <= COLOR_BLACK; ++c) {
+                if (attacked_raywalk(&positions[i], sq / 8, sq % 8, c) !=
+                    board_is_square_attacked(&positions[i], sq / 8, sq % 8, c)) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    unsigned long long queries = (unsigned long long)count * 64 * 2 * rounds;
+    volatile long sink = 0;
+
+    double t0 = now_seconds();
+    for (int k = 0; k < rounds; ++k)
+        for (size_t i = 0; i < count; ++i)
+            for (int sq = 0; sq < 64; ++sq) {
+                sink += attacked_raywalk(&positions[i], sq / 8, sq % 8, COLOR_WHITE);
+                sink += attacked_raywalk(&positions[i], sq / 8, sq % 8, COLOR_BLACK);
+            }
+    double t_ray = now_seconds() - t0;
+
+    t0 = now_seconds();
+    for (int k = 0; k < rounds; ++k)
+        for (size_t i = 0; i < count; ++i)
+            for (int sq = 0; sq < 64; ++sq) {
+                sink += board_is_square_attacked(&positions[i], sq / 8, sq % 8, COLOR_WHITE);
+                sink += board_is_square_attacked(&positions[i], sq / 8, sq % 8, COLOR_BLACK);
+            }
+    double t_table = now_seconds() - t0;
+
+    printf("Posiciones: %zu (%s)\n", count, path);
+    printf("Consultas por implementación: %llu\n", queries);
+    printf("Discrepancias: %zu\n", mismatches);
+    printf("  Recorrido de rayos: %8.3f s  %7.2f ns/consulta\n",
+           t_ray, t_ray * 1e9 / queries);
+    printf("  Tablas de ataque:   %8.3f s  %7.2f ns/consulta\n",
+           t_table, t_table * 1e9 / queries);
+    printf("  Aceleración:        %8.2fx\n", t_ray / t_table);
+
+    free(positions);
+    return mismatches ? 1 : 0;
+}
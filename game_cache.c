@@ -0,0 +1,372 @@
+// game_cache.c - Caché binaria de partidas ya validadas
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "game_cache.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+// Formato (enteros en el orden de bytes de la máquina que la escribió):
+//   cabecera de GAME_CACHE_HEADER bytes (CacheHeader)
+//   por partida:
+//     u32 bytes del resto del registro
+//     u8 estado final, u8 bando inicial, u8 hay textos, u8 relleno
+//     u32 cantidad de jugadas
+//     6 cadenas (evento, blancas, negras, resultado, FEN, etiquetas):
+//       u16 longitud + bytes + '\0'
+//     códigos: 2 bytes por jugada
+//     si hay textos: u32 longitud + textos SAN terminados en '\0'
+
+#define GAME_CACHE_MAGIC  "CGC\x1a"
+#define GAME_CACHE_ENDIAN 0x01020304u
+#define GAME_CACHE_HEADER 64
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t reserved;
+    uint64_t file_size;
+    int64_t mtime;
+    uint64_t content_hash;
+    uint32_t games;
+    uint32_t processed;
+} CacheHeader;
+
+// ============================================================================
+// IDENTIDAD DEL ARCHIVO
+// ============================================================================
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Hash de 64 bits del contenido: 8 bytes por paso (multiplicar y rotar) y
+// mezcla final, suficiente para detectar cambios en el archivo
+static uint64_t content_hash(const unsigned char *p, size_t len) {
+    const uint64_t k1 = 0x87C37B91114253D5ULL, k2 = 0x4CF5AD432745937FULL;
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ len;
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        h ^= rotl64(w * k1, 31) * k2;
+        h = rotl64(h, 27) * 5 + 0x52DCE729;
+    }
+
+    uint64_t tail = 0;
+    for (size_t j = 0; i + j < len; j++) tail |= (uint64_t)p[i + j] << (8 * j);
+    h ^= rotl64(tail * k1, 31) * k2;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Lee el archivo completo: proyección en memoria (o copia con malloc)
+static const unsigned char *map_file(const char *path, size_t *len, int *owns_copy) {
+    *len = 0;
+    *owns_copy = 0;
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return NULL;
+    *len = (size_t)st.st_size;
+    return m;
+#else
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *data = (size > 0) ? malloc((size_t)size) : NULL;
+    if (!data || fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    *len = (size_t)size;
+    *owns_copy = 1;
+    return data;
+#endif
+}
+
+static void unmap_file(const unsigned char *data, size_t len, int owns_copy) {
+    if (!data) return;
+    if (owns_copy) {
+        free((void *)data);
+        return;
+    }
+#if !defined(_WIN32)
+    munmap((void *)data, len);
+#else
+    (void)len;
+#endif
+}
+
+int game_cache_key(const char *pgn_path, GameCacheKey *key) {
+    struct stat st;
+    if (stat(pgn_path, &st) != 0 || !S_ISREG(st.st_mode)) return -1;
+
+    key->file_size = (uint64_t)st.st_size;
+    key->mtime = (int64_t)st.st_mtime;
+    key->content_hash = 0;
+    if (st.st_size == 0) return 0;
+
+    size_t len;
+    int owns_copy;
+    const unsigned char *data = map_file(pgn_path, &len, &owns_copy);
+    if (!data) return -1;
+    key->content_hash = content_hash(data, len);
+    unmap_file(data, len, owns_copy);
+    return 0;
+}
+
+char *game_cache_path(const char *pgn_path) {
+    size_t n = strlen(pgn_path);
+    char *path = malloc(n + 5);
+    if (!path) return NULL;
+    memcpy(path, pgn_path, n);
+    memcpy(path + n, ".cgc", 5);
+    return path;
+}
+
+// ============================================================================
+// LECTURA
+// ============================================================================
+
+int game_cache_open(GameCacheReader *r, const char *pgn_path, const GameCacheKey *key) {
+    memset(r, 0, sizeof(*r));
+
+    char *path = game_cache_path(pgn_path);
+    if (!path) return 0;
+    r->data = map_file(path, &r->len, &r->owns_copy);
+    free(path);
+    if (!r->data) return 0;
+
+    CacheHeader h;
+    if (r->len < GAME_CACHE_HEADER) goto invalid;
+    memcpy(&h, r->data, sizeof(h));
+    if (memcmp(h.magic, GAME_CACHE_MAGIC, 4) != 0 ||
+        h.version != GAME_CACHE_VERSION ||
+        h.endian != GAME_CACHE_ENDIAN ||
+        h.file_size != key->file_size ||
+        h.mtime != key->mtime ||
+        h.content_hash != key->content_hash) {
+        goto invalid;
+    }
+
+    r->games = (int)h.games;
+    r->processed = (int)h.processed;
+    r->pos = GAME_CACHE_HEADER;
+#if !defined(_WIN32)
+    if (!r->owns_copy) madvise((void *)r->data, r->len, MADV_SEQUENTIAL);
+#endif
+    return 1;
+
+invalid:
+    game_cache_close(r);
+    return 0;
+}
+
+// Lee una cadena u16 + bytes + '\0' dentro de [*p, end)
+static int read_string(const unsigned char **p, const unsigned char *end, const char **out) {
+    uint16_t n;
+    if (end - *p < 2) return -1;
+    memcpy(&n, *p, 2);
+    *p += 2;
+    if (end - *p < (ptrdiff_t)n + 1 || (*p)[n] != '\0') return -1;
+    *out = (const char *)*p;
+    *p += n + 1;
+    return 0;
+}
+
+int game_cache_next(GameCacheReader *r, GameCacheRecord *rec) {
+    if (r->pos >= r->len) return 0;
+    if (r->len - r->pos < 4) return -1;
+
+    uint32_t size;
+    memcpy(&size, r->data + r->pos, 4);
+    if (size > r->len - r->pos - 4) return -1;
+
+    const unsigned char *p = r->data + r->pos + 4;
+    const unsigned char *end = p + size;
+    uint32_t count;
+
+    if (end - p < 8) return -1;
+    rec->final_status = (PositionStatus)p[0];
+    rec->start_side = (Color)p[1];
+    int has_text = p[2];
+    memcpy(&count, p + 4, 4);
+    p += 8;
+
+    if (read_string(&p, end, &rec->event) != 0 ||
+        read_string(&p, end, &rec->white) != 0 ||
+        read_string(&p, end, &rec->black) != 0 ||
+        read_string(&p, end, &rec->result) != 0 ||
+        read_string(&p, end, &rec->fen) != 0 ||
+        read_string(&p, end, &rec->tags) != 0) {
+        return -1;
+    }
+
+    if ((size_t)(end - p) < (size_t)count * 2) return -1;
+    rec->move_count = (int)count;
+    rec->codes = p;
+    p += (size_t)count * 2;
+
+    rec->texts = NULL;
+    rec->texts_len = 0;
+    if (has_text) {
+        uint32_t n;
+        if (end - p < 4) return -1;
+        memcpy(&n, p, 4);
+        p += 4;
+        if ((size_t)(end - p) < n || (n > 0 && p[n - 1] != '\0')) return -1;
+        rec->texts = (const char *)p;
+        rec->texts_len = n;
+    }
+
+    r->pos += 4 + (size_t)size;
+    return 1;
+}
+
+void game_cache_close(GameCacheReader *r) {
+    unmap_file(r->data, r->len, r->owns_copy);
+    r->data = NULL;
+    r->len = 0;
+}
+
+// ============================================================================
+// ESCRITURA
+// ============================================================================
+
+int game_cache_create(GameCacheWriter *w, const char *pgn_path, const GameCacheKey *key) {
+    memset(w, 0, sizeof(*w));
+    w->key = *key;
+    w->path = game_cache_path(pgn_path);
+    if (!w->path) return -1;
+
+    size_t n = strlen(w->path);
+    w->tmp_path = malloc(n + 5);
+    if (!w->tmp_path) {
+        game_cache_abort(w);
+        return -1;
+    }
+    memcpy(w->tmp_path, w->path, n);
+    memcpy(w->tmp_path + n, ".tmp", 5);
+
+    w->f = fopen(w->tmp_path, "wb");
+    if (!w->f) {
+        game_cache_abort(w);
+        return -1;
+    }
+
+    // La cabecera se completa en game_cache_commit
+    unsigned char zero[GAME_CACHE_HEADER] = {0};
+    if (fwrite(zero, 1, sizeof(zero), w->f) != sizeof(zero)) {
+        game_cache_abort(w);
+        return -1;
+    }
+    return 0;
+}
+
+static size_t string_size(const char *s) {
+    return 2 + strlen(s) + 1;
+}
+
+static void write_string(FILE *f, const char *s) {
+    uint16_t n = (uint16_t)strlen(s);
+    fwrite(&n, 2, 1, f);
+    fwrite(s, 1, (size_t)n + 1, f);
+}
+
+int game_cache_write(GameCacheWriter *w, const GameCacheRecord *rec) {
+    const char *strings[6] = {
+        rec->event, rec->white, rec->black, rec->result, rec->fen, rec->tags
+    };
+
+    size_t size = 8 + (size_t)rec->move_count * 2;
+    for (int i = 0; i < 6; i++) {
+        if (strlen(strings[i]) > 0xFFFF) return -1;
+        size += string_size(strings[i]);
+    }
+    if (rec->texts) size += 4 + rec->texts_len;
+
+    uint32_t size32 = (uint32_t)size;
+    uint32_t count = (uint32_t)rec->move_count;
+    unsigned char flags[4] = {
+        (unsigned char)rec->final_status, (unsigned char)rec->start_side,
+        rec->texts ? 1 : 0, 0
+    };
+
+    fwrite(&size32, 4, 1, w->f);
+    fwrite(flags, 1, 4, w->f);
+    fwrite(&count, 4, 1, w->f);
+    for (int i = 0; i < 6; i++) write_string(w->f, strings[i]);
+    fwrite(rec->codes, 2, (size_t)rec->move_count, w->f);
+    if (rec->texts) {
+        uint32_t n = (uint32_t)rec->texts_len;
+        fwrite(&n, 4, 1, w->f);
+        fwrite(rec->texts, 1, rec->texts_len, w->f);
+    }
+
+    w->games++;
+    return ferror(w->f) ? -1 : 0;
+}
+
+int game_cache_commit(GameCacheWriter *w, int processed) {
+    CacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, GAME_CACHE_MAGIC, 4);
+    h.version = GAME_CACHE_VERSION;
+    h.endian = GAME_CACHE_ENDIAN;
+    h.file_size = w->key.file_size;
+    h.mtime = w->key.mtime;
+    h.content_hash = w->key.content_hash;
+    h.games = (uint32_t)w->games;
+    h.processed = (uint32_t)processed;
+
+    int ok = fseek(w->f, 0, SEEK_SET) == 0 &&
+             fwrite(&h, sizeof(h), 1, w->f) == 1 &&
+             fflush(w->f) == 0 && !ferror(w->f);
+    ok = (fclose(w->f) == 0) && ok;
+    w->f = NULL;
+
+#if defined(_WIN32)
+    if (ok) remove(w->path);   // rename no reemplaza archivos en Windows
+#endif
+    if (ok) ok = (rename(w->tmp_path, w->path) == 0);
+    if (!ok) remove(w->tmp_path);
+
+    free(w->path);
+    free(w->tmp_path);
+    w->path = w->tmp_path = NULL;
+    return ok ? 0 : -1;
+}
+
+void game_cache_abort(GameCacheWriter *w) {
+    if (w->f) {
+        fclose(w->f);
+        remove(w->tmp_path);
+    }
+    w->f = NULL;
+    free(w->path);
+    free(w->tmp_path);
+    w->path = w->tmp_path = NULL;
+}
@@ -0,0 +1,90 @@
+// game_cache.h - Caché binaria de partidas ya validadas (<archivo>.cgc)
+//
+// Al terminar de cargar un PGN se guardan junto a él las etiquetas y los
+// códigos de 16 bits de las jugadas de cada partida válida. La caché se
+// identifica por el tamaño, la fecha de modificación y un hash del
+// contenido del PGN; si el archivo no cambió, la siguiente carga lee la
+// caché (proyectada en memoria) en lugar de volver a validar las jugadas.
+#ifndef GAME_CACHE_H
+#define GAME_CACHE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "semant.h"
+
+// Cambia cuando cambia el formato o las reglas de validación: las cachés
+// de otra versión se ignoran y se vuelven a crear
+#define GAME_CACHE_VERSION 2
+
+// Identidad del PGN del que salió la caché
+typedef struct {
+    uint64_t file_size;
+    int64_t mtime;
+    uint64_t content_hash;
+} GameCacheKey;
+
+// Partida guardada. Las cadenas y arrays apuntan a la caché (lectura) o al
+// llamador (escritura); las cadenas terminan en '\0'
+typedef struct {
+    const char *event;
+    const char *white;
+    const char *black;
+    const char *result;
+    const char *fen;              // "" = posición estándar
+    const char *tags;             // Todas las etiquetas, líneas [Nombre "Valor"]
+    PositionStatus final_status;
+    Color start_side;
+    int move_count;
+    const unsigned char *codes;   // move_count códigos de 16 bits (sin alinear)
+    const char *texts;            // Textos SAN seguidos, cada uno terminado en '\0';
+                                  // NULL = no se guardaron (carga en modo compacto)
+    size_t texts_len;
+} GameCacheRecord;
+
+// Lectura: la caché proyectada en memoria
+typedef struct {
+    const unsigned char *data;
+    size_t len;
+    size_t pos;
+    int games;                    // Partidas válidas guardadas
+    int processed;                // Partidas del PGN (válidas e inválidas)
+    int owns_copy;                // 1 si 'data' se leyó con malloc (sin mmap)
+} GameCacheReader;
+
+// Escritura a un archivo temporal que se renombra al confirmar
+typedef struct {
+    FILE *f;
+    char *path;
+    char *tmp_path;
+    GameCacheKey key;
+    int games;
+} GameCacheWriter;
+
+// Calcula la identidad del archivo 'pgn_path'. 0 = éxito
+int game_cache_key(const char *pgn_path, GameCacheKey *key);
+
+// Abre la caché de 'pgn_path' si existe y corresponde a 'key'.
+// 1 = abierta, 0 = no hay caché válida
+int game_cache_open(GameCacheReader *r, const char *pgn_path, const GameCacheKey *key);
+
+// Siguiente partida. 1 = hay partida, 0 = fin, -1 = caché dañada
+int game_cache_next(GameCacheReader *r, GameCacheRecord *rec);
+
+void game_cache_close(GameCacheReader *r);
+
+// Empieza a escribir la caché de 'pgn_path'. 0 = éxito
+int game_cache_create(GameCacheWriter *w, const char *pgn_path, const GameCacheKey *key);
+
+// Agrega una partida. 0 = éxito
+int game_cache_write(GameCacheWriter *w, const GameCacheRecord *rec);
+
+// Completa la cabecera y reemplaza la caché anterior. 0 = éxito
+int game_cache_commit(GameCacheWriter *w, int processed);
+
+// Descarta la escritura en curso
+void game_cache_abort(GameCacheWriter *w);
+
+// Ruta de la caché de 'pgn_path' (reservada con malloc)
+char *game_cache_path(const char *pgn_path);
+
+#endif // GAME_CACHE_H
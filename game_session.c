@@ -0,0 +1,208 @@
+// game_session.c - Partida en vivo sobre el motor de semant.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "ast.h"
+#include "parser.h"
+#include "semant.h"
+#include "game_session.h"
+
+// ==================== CREACIÓN ====================
+
+GameSession *game_session_create(const char *fen, int undo_depth) {
+    if (undo_depth <= 0) undo_depth = GAME_SESSION_DEFAULT_UNDO;
+
+    // Una sola reserva: la sesión y su anillo para deshacer
+    GameSession *s = malloc(sizeof(GameSession) + (size_t)undo_depth * sizeof(GameSessionUndo));
+    if (!s) return NULL;
+
+    int halfmove = 0;
+    int fullmove = 1;
+    s->side_to_move = COLOR_WHITE;
+    if (!fen) {
+        board_init_start(&s->board);
+    } else if (board_from_fen(&s->board, fen, &s->side_to_move, &halfmove, &fullmove) != 0) {
+        free(s);
+        return NULL;
+    }
+
+    s->fullmove_start = fullmove > 0 ? fullmove : 1;
+    s->plies = 0;
+    history_init(&s->history, &s->board);
+    s->history.halfmove_clock = halfmove;
+    s->status = history_evaluate_status(&s->history, &s->board, s->side_to_move);
+    s->undo_capacity = undo_depth;
+    s->undo_count = 0;
+    return s;
+}
+
+void game_session_free(GameSession *s) {
+    free(s);
+}
+
+// ==================== JUGADAS ====================
+
+static void set_error(GameSessionMove *out, const char *msg) {
+    if (out) snprintf(out->error, sizeof(out->error), "%s", msg);
+}
+
+// Registra una jugada ya hecha en el tablero ('undo' la deshace): guarda lo
+// necesario para deshacerla y actualiza turno, historial y estado. Sin
+// reservas: la entrada del anillo ya existe
+static void session_commit(GameSession *s, const MoveUndo *undo, GameSessionMove *out) {
+    GameSessionUndo *u = &s->undo[s->plies % s->undo_capacity];
+    u->undo = *undo;
+    u->halfmove_clock = (unsigned short)s->history.halfmove_clock;
+    u->status = (unsigned char)s->status;
+    u->history_key = s->history.keys[s->history.count % POSITION_HISTORY_SIZE];
+
+    s->side_to_move = (s->side_to_move == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    history_push(&s->history, &s->board);
+    s->status = history_evaluate_status(&s->history, &s->board, s->side_to_move);
+    s->plies++;
+    if (s->undo_count < s->undo_capacity) s->undo_count++;
+
+    if (out) out->status = s->status;
+}
+
+// Aplica una jugada legal de la posición actual
+static void session_apply(GameSession *s, Move m, GameSessionMove *out) {
+    // La SAN se calcula con la posición previa a la jugada
+    if (out) {
+        out->move = m;
+        board_move_to_san(&s->board, m, out->san, sizeof(out->san));
+        out->error[0] = '\0';
+    }
+
+    MoveUndo undo;
+    board_make_move(&s->board, m, &undo);
+    session_commit(s, &undo, out);
+}
+
+int game_session_push_san(GameSession *s, const char *san, size_t len, GameSessionMove *out) {
+    MoveAST ast;
+    int perr = san_parse(san, len, &ast);
+    if (perr != 0) {
+        set_error(out, perr == -1 ? "Símbolo no reconocido en la jugada."
+                                  : "El movimiento no cumple con la notación SAN estándar.");
+        return -1;
+    }
+
+    // Misma validación que la carga de PGN; la jugada queda hecha en el
+    // tablero de la sesión, sin copiarlo
+    MoveUndo undo;
+    char err[256];
+    if (board_apply_move_undo(&s->board, &ast, s->side_to_move, &undo, err, sizeof(err)) != 0) {
+        set_error(out, err);
+        return -1;
+    }
+
+    // La SAN canónica se escribe desde la posición previa a la jugada
+    if (out) {
+        board_unmake_move(&s->board, &undo);
+        out->move = undo.move;
+        board_move_to_san(&s->board, undo.move, out->san, sizeof(out->san));
+        out->error[0] = '\0';
+        board_make_move(&s->board, undo.move, &undo);
+    }
+
+    session_commit(s, &undo, out);
+    return 0;
+}
+
+int game_session_push_uci(GameSession *s, const char *uci, GameSessionMove *out) {
+    // Formato: origen, destino y pieza de promoción opcional ("e7e8q")
+    size_t len = strlen(uci);
+    if ((len != 4 && len != 5) ||
+        uci[0] < 'a' || uci[0] > 'h' || uci[1] < '1' || uci[1] > '8' ||
+        uci[2] < 'a' || uci[2] > 'h' || uci[3] < '1' || uci[3] > '8') {
+        set_error(out, "Jugada UCI mal formada.");
+        return -1;
+    }
+    int from = (uci[1] - '1') * 8 + (uci[0] - 'a');
+    int to = (uci[3] - '1') * 8 + (uci[2] - 'a');
+
+    int promo = 0;
+    if (len == 5) {
+        switch (tolower((unsigned char)uci[4])) {
+            case 'n': promo = MOVE_PROMO_KNIGHT; break;
+            case 'b': promo = MOVE_PROMO_BISHOP; break;
+            case 'r': promo = MOVE_PROMO_ROOK; break;
+            case 'q': promo = MOVE_PROMO_QUEEN; break;
+            default:
+                set_error(out, "Pieza de promoción inválida.");
+                return -1;
+        }
+    }
+
+    // Los enroques se escriben como jugada del rey (e1g1), igual que en Move
+    MoveList list;
+    board_generate_legal_moves(&s->board, s->side_to_move, &list);
+    int missing_promo = 0;
+    for (int i = 0; i < list.count; i++) {
+        Move m = list.moves[i];
+        if (MOVE_FROM(m) != from || MOVE_TO(m) != to) continue;
+        if (MOVE_IS_PROMOTION(m) ? MOVE_KIND(m) != promo : promo != 0) {
+            if (promo == 0) missing_promo = 1;
+            continue;
+        }
+        session_apply(s, m, out);
+        return 0;
+    }
+
+    set_error(out, missing_promo ? "Falta la pieza de promoción."
+                                 : "Movimiento ilegal en la posición actual.");
+    return -1;
+}
+
+int game_session_undo(GameSession *s) {
+    if (s->undo_count == 0) return -1;
+
+    s->plies--;
+    s->undo_count--;
+    const GameSessionUndo *u = &s->undo[s->plies % s->undo_capacity];
+    board_unmake_move(&s->board, &u->undo);
+    s->side_to_move = (s->side_to_move == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+
+    // El historial vuelve a la posición anterior: se restituye la clave que
+    // la jugada pisó en el anillo y el reloj de la regla de 50
+    PositionHistory *h = &s->history;
+    h->count--;
+    h->keys[h->count % POSITION_HISTORY_SIZE] = u->history_key;
+    h->halfmove_clock = u->halfmove_clock;
+    h->last_pawns = s->board.pieces[0][PIECE_PAWN - 1] | s->board.pieces[1][PIECE_PAWN - 1];
+    h->last_pieces = __builtin_popcountll(s->board.occupied_all);
+
+    s->status = (PositionStatus)u->status;
+    return 0;
+}
+
+// ==================== CONSULTAS ====================
+
+PositionStatus game_session_status(const GameSession *s) {
+    return s->status;
+}
+
+const char *game_session_status_name(PositionStatus st) {
+    switch (st) {
+        case POSITION_CHECK:           return "check";
+        case POSITION_CHECKMATE:       return "checkmate";
+        case POSITION_STALEMATE:       return "stalemate";
+        case POSITION_DRAW_REPETITION: return "repetition";
+        case POSITION_DRAW_FIFTY_MOVE: return "fifty_move";
+        default:                       return "normal";
+    }
+}
+
+Color game_session_side_to_move(const GameSession *s) {
+    return s->side_to_move;
+}
+
+int game_session_fen(const GameSession *s, char *out, size_t out_size) {
+    // Las jugadas completas avanzan cuando juegan las negras
+    int start_black = (s->side_to_move == COLOR_BLACK) != (s->plies % 2 == 1);
+    int fullmove = s->fullmove_start + (s->plies + start_black) / 2;
+    return board_to_fen(&s->board, s->side_to_move, s->history.halfmove_clock,
+                        fullmove, out, out_size);
+}
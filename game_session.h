@@ -0,0 +1,80 @@
+// game_session.h - Partida en vivo: jugadas de una en una sobre el motor
+//
+// Una sesión guarda la posición, el turno, las claves de las posiciones
+// (repeticiones y regla de 50 jugadas) y un anillo de datos para deshacer
+// las últimas jugadas. Todo se reserva al crearla: aplicar, deshacer o
+// consultar una jugada no reserva memoria y cuesta lo mismo en cualquier
+// punto de la partida, así un proceso puede llevar decenas de miles de
+// partidas a la vez.
+#ifndef GAME_SESSION_H
+#define GAME_SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "semant.h"
+
+// Jugadas que se pueden deshacer por defecto (las más antiguas se olvidan)
+#define GAME_SESSION_DEFAULT_UNDO 256
+
+// Datos para deshacer una jugada
+typedef struct {
+    MoveUndo undo;
+    uint64_t history_key;             // Clave del historial que pisó la jugada
+    unsigned short halfmove_clock;    // Reloj de la regla de 50 antes de la jugada
+    unsigned char status;             // PositionStatus antes de la jugada
+} GameSessionUndo;
+
+typedef struct {
+    Board board;
+    Color side_to_move;
+    int fullmove_start;               // Número de jugada de la posición inicial
+    int plies;                        // Medias jugadas hechas desde la posición inicial
+    PositionStatus status;            // Estado de la posición actual
+    PositionHistory history;
+
+    int undo_capacity;                // Tamaño del anillo 'undo'
+    int undo_count;                   // Jugadas que se pueden deshacer
+    GameSessionUndo undo[];           // undo[ply % undo_capacity]
+} GameSession;
+
+// Resultado de aplicar una jugada
+typedef struct {
+    Move move;                        // Jugada aplicada (16 bits)
+    char san[16];                     // SAN canónica, con desambiguación y +/#
+    PositionStatus status;            // Estado tras la jugada (jaque, mate, tablas, ...)
+    char error[256];                  // Razón, si la jugada no se aplicó
+} GameSessionMove;
+
+// Crea una sesión desde un FEN (NULL = posición inicial) que puede deshacer
+// hasta 'undo_depth' jugadas (<= 0 = GAME_SESSION_DEFAULT_UNDO).
+// NULL si el FEN es inválido o no hay memoria
+GameSession *game_session_create(const char *fen, int undo_depth);
+
+void game_session_free(GameSession *s);
+
+// Aplica una jugada en SAN ("Nf3", "exd5", "O-O", "e8=Q#"), con las mismas
+// reglas que la validación de PGN. 0 = aplicada, -1 = inválida (el motivo
+// queda en out->error). 'out' puede ser NULL
+int game_session_push_san(GameSession *s, const char *san, size_t len, GameSessionMove *out);
+
+// Aplica una jugada en notación UCI ("e2e4", "e1g1", "e7e8q").
+// 0 = aplicada, -1 = inválida. 'out' puede ser NULL
+int game_session_push_uci(GameSession *s, const char *uci, GameSessionMove *out);
+
+// Deshace la última jugada. 0 = éxito, -1 = no hay jugadas para deshacer
+int game_session_undo(GameSession *s);
+
+// Estado de la posición actual (calculado al aplicar o deshacer)
+PositionStatus game_session_status(const GameSession *s);
+
+// Nombre del estado para protocolos y registros: "normal", "check",
+// "checkmate", "stalemate", "repetition" o "fifty_move"
+const char *game_session_status_name(PositionStatus st);
+
+// Bando al que le toca jugar
+Color game_session_side_to_move(const GameSession *s);
+
+// Posición actual en FEN. Devuelve la longitud, o -1 si no cabe
+int game_session_fen(const GameSession *s, char *out, size_t out_size);
+
+#endif // GAME_SESSION_H
@@ -29,6 +29,10 @@ int partida_normal_mode(void)
     Board board;
     board_init_start(&board);
 
+    // Posiciones de la partida (repeticiones y regla de 50 jugadas)
+    PositionHistory history;
+    history_init(&history, &board);
+
     Color side = COLOR_WHITE;
     char input[32];
 
@@ -68,8 +72,8 @@ int partida_normal_mode(void)
         int df = file_to_index(input[2]);   // destino columna
         int dr = rank_to_index(input[3]);   // destino fila
 
-        Piece p = board.board[sr][sf];
-        Piece dest = board.board[dr][df];
+        Piece p = board_piece_at(&board, sr, sf);
+        Piece dest = board_piece_at(&board, dr, df);
 
         if (p.type == PIECE_NONE || p.color != side) {
             printf("No hay pieza propia en la casilla de origen.\n");
@@ -103,7 +107,7 @@ int partida_normal_mode(void)
                         continue;
                     }
                     int intermediate_rank = sr + dir;
-                    if (board.board[intermediate_rank][sf].type != PIECE_NONE ||
+                    if (board_piece_at(&board, intermediate_rank, sf).type != PIECE_NONE ||
                         dest.type != PIECE_NONE) 
                     {
                         printf("Movimiento ilegal: hay piezas bloqueando el avance de dos casillas.\n");
@@ -216,6 +220,14 @@ int partida_normal_mode(void)
 
         // cambiar turno
         side = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+
+        history_push(&history, &board);
+        PositionStatus st = history_evaluate_status(&history, &board, side);
+        if (st == POSITION_DRAW_REPETITION) {
+            printf("TABLAS por triple repetición.\n");
+        } else if (st == POSITION_DRAW_FIFTY_MOVE) {
+            printf("TABLAS por la regla de las 50 jugadas.\n");
+        }
     }
 
     // en teoría no se llega aquí
@@ -230,6 +242,10 @@ int interactive_mode(void) {
     board_init_start(&board);
     board_print(&board);
 
+    // Posiciones de la partida (repeticiones y regla de 50 jugadas)
+    PositionHistory history;
+    history_init(&history, &board);
+
     Color side_to_move = COLOR_WHITE;
 
     while (1) {
@@ -279,7 +295,8 @@ int interactive_mode(void) {
             printf("\nMovimiento semánticamente válido. Tablero actualizado:\n");
             board_print(&board);
 
-            PositionStatus st = board_evaluate_status(&board,
+            history_push(&history, &board);
+            PositionStatus st = history_evaluate_status(&history, &board,
                                               (side_to_move == COLOR_WHITE)
                                                 ? COLOR_BLACK
                                                 : COLOR_WHITE);
@@ -294,6 +311,12 @@ int interactive_mode(void) {
                 case POSITION_STALEMATE:
                     printf("La posición resultante es TABLAS por ahogado.\n\n");
                     break;
+                case POSITION_DRAW_REPETITION:
+                    printf("La posición resultante es TABLAS por triple repetición.\n\n");
+                    break;
+                case POSITION_DRAW_FIFTY_MOVE:
+                    printf("La posición resultante es TABLAS por la regla de las 50 jugadas.\n\n");
+                    break;
                 default:
                     break;
             }
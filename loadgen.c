@@ -0,0 +1,301 @@
+// loadgen.c - Generador de carga para el servidor de partidas (chess serve)
+//
+// Abre muchas conexiones al servidor y juega en cada una una partida con
+// jugadas legales al azar: elige la jugada con su propia GameSession, la
+// envía con MOVE, comprueba que la SAN y el estado de la respuesta son los
+// esperados y mide el tiempo hasta la respuesta. Cada conexión tiene una
+// sola petición en curso. Al terminar muestra las jugadas por segundo y la
+// latencia por jugada (p50, p90, p99, p99.9 y máxima).
+//
+// Compilar:
+//   gcc -O2 -o loadgen loadgen.c game_session.c semant.c attacks.c zobrist.c lexer.c parser.c status_cache.c -pthread
+// Ejecutar (con ./chess serve corriendo):
+//   ./loadgen [--socket RUTA | --tcp PUERTO] [-c conexiones] [-n jugadas] [--plies N] [--seed N]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "semant.h"
+#include "game_session.h"
+
+// Petición en curso de una conexión
+typedef enum {
+    REQ_NEW,
+    REQ_MOVE,
+    REQ_UNDO
+} RequestKind;
+
+typedef struct {
+    int fd;
+    GameSession *game;                // Copia local de la partida
+    RequestKind pending;
+    char expected[64];                // Respuesta esperada a MOVE / UNDO
+    uint64_t sent_ns;
+    int plies;
+    char in[512];
+    int in_len;
+} Client;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Generador xorshift: partidas reproducibles con --seed
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static int connect_server(const char *socket_path, int tcp_port) {
+    int fd;
+    if (tcp_port) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((unsigned short)tcp_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) goto fail;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    } else {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) goto fail;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+
+fail:
+    perror(tcp_port ? "127.0.0.1" : socket_path);
+    if (fd >= 0) close(fd);
+    return -1;
+}
+
+static int send_line(Client *c, const char *line) {
+    size_t len = strlen(line);
+    c->sent_ns = now_ns();
+    return send(c->fd, line, len, MSG_NOSIGNAL) == (ssize_t)len ? 0 : -1;
+}
+
+// Envía la siguiente petición de la conexión: NEW al terminar la partida,
+// a veces UNDO y si no una jugada legal al azar
+static int send_next(Client *c, int max_plies) {
+    PositionStatus st = game_session_status(c->game);
+    if (c->plies >= max_plies || st == POSITION_CHECKMATE || st == POSITION_STALEMATE ||
+        st == POSITION_DRAW_REPETITION || st == POSITION_DRAW_FIFTY_MOVE) {
+        game_session_free(c->game);
+        c->game = game_session_create(NULL, 4);
+        c->plies = 0;
+        c->pending = REQ_NEW;
+        return send_line(c, "NEW\n");
+    }
+
+    if (c->game->undo_count > 0 && rng_next() % 50 == 0) {
+        game_session_undo(c->game);
+        c->plies--;
+        c->pending = REQ_UNDO;
+        snprintf(c->expected, sizeof(c->expected), "OK %s",
+                 game_session_status_name(game_session_status(c->game)));
+        return send_line(c, "UNDO\n");
+    }
+
+    MoveList list;
+    board_generate_legal_moves(&c->game->board, c->game->side_to_move, &list);
+    char san[16];
+    board_move_to_san(&c->game->board, list.moves[rng_next() % list.count], san, sizeof(san));
+
+    GameSessionMove mv;
+    if (game_session_push_san(c->game, san, strlen(san), &mv) != 0) {
+        fprintf(stderr, "Jugada local rechazada: %s (%s)\n", san, mv.error);
+        return -1;
+    }
+    c->plies++;
+    c->pending = REQ_MOVE;
+    snprintf(c->expected, sizeof(c->expected), "OK %s %s", mv.san, game_session_status_name(mv.status));
+
+    char line[32];
+    snprintf(line, sizeof(line), "MOVE %s\n", san);
+    return send_line(c, line);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint64_t *sorted, long n, double q) {
+    if (n == 0) return 0.0;
+    return sorted[(long)(q * (double)(n - 1))] / 1000.0;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Uso: loadgen [--socket RUTA | --tcp PUERTO] [-c conexiones] [-n jugadas] [--plies N] [--seed N]\n");
+    fprintf(stderr, "  --socket RUTA   Socket Unix del servidor (por defecto chess.sock)\n");
+    fprintf(stderr, "  --tcp PUERTO    Servidor TCP en 127.0.0.1\n");
+    fprintf(stderr, "  -c N            Conexiones (partidas) simultáneas (por defecto 1000)\n");
+    fprintf(stderr, "  -n N            Jugadas a enviar en total (por defecto 200000)\n");
+    fprintf(stderr, "  --plies N       Medias jugadas por partida antes de empezar otra (por defecto 120)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *socket_path = "chess.sock";
+    int tcp_port = 0;
+    int conns = 1000;
+    long total = 200000;
+    int max_plies = 120;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--tcp") == 0 && i + 1 < argc) {
+            tcp_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            conns = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            total = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--plies") == 0 && i + 1 < argc) {
+            max_plies = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            rng_state ^= (uint64_t)strtoull(argv[++i], NULL, 10) * 0x9E3779B97F4A7C15ull;
+            if (rng_state == 0) rng_state = 1;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (conns < 1 || total < 1 || max_plies < 1) {
+        usage();
+        return 2;
+    }
+
+    // Una conexión por partida: se sube el límite de descriptores abiertos
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    Client *clients = calloc((size_t)conns, sizeof(Client));
+    uint64_t *latency = malloc((size_t)total * sizeof(uint64_t));
+    int epoll_fd = epoll_create1(0);
+    if (!clients || !latency || epoll_fd < 0) {
+        fprintf(stderr, "No se pudo preparar el generador de carga\n");
+        return 2;
+    }
+
+    long sent = 0;       // Jugadas enviadas
+    long done = 0;       // Jugadas respondidas
+    long mismatches = 0;
+    int open_clients = 0;
+    uint64_t t0 = now_ns();
+
+    for (int i = 0; i < conns; i++) {
+        Client *c = &clients[i];
+        c->fd = connect_server(socket_path, tcp_port);
+        if (c->fd < 0) return 2;
+        c->game = game_session_create(NULL, 4);
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, c->fd, &ev);
+        c->pending = REQ_NEW;
+        if (send_line(c, "NEW\n") != 0) {
+            perror("send");
+            return 2;
+        }
+        open_clients++;
+    }
+
+    struct epoll_event events[256];
+    while (open_clients > 0) {
+        int n = epoll_wait(epoll_fd, events, 256, 5000);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            return 2;
+        }
+        if (n == 0) {
+            fprintf(stderr, "El servidor no responde\n");
+            return 2;
+        }
+        for (int e = 0; e < n; e++) {
+            Client *c = events[e].data.ptr;
+            ssize_t r = read(c->fd, c->in + c->in_len, sizeof(c->in) - 1 - (size_t)c->in_len);
+            if (r <= 0) {
+                if (r < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+                fprintf(stderr, "El servidor cerró la conexión\n");
+                return 2;
+            }
+            uint64_t t = now_ns();
+            c->in_len += (int)r;
+            c->in[c->in_len] = '\0';
+
+            char *nl = strchr(c->in, '\n');
+            if (!nl) continue;   // Respuesta incompleta
+            *nl = '\0';
+
+            if (c->pending == REQ_MOVE) {
+                latency[done++] = t - c->sent_ns;
+            }
+            int ok = (c->pending == REQ_NEW) ? strcmp(c->in, "OK") == 0
+                                             : strcmp(c->in, c->expected) == 0;
+            if (!ok) {
+                if (mismatches < 10) {
+                    fprintf(stderr, "Respuesta inesperada: '%s' (se esperaba '%s')\n",
+                            c->in, c->pending == REQ_NEW ? "OK" : c->expected);
+                }
+                mismatches++;
+            }
+            c->in_len = 0;   // Una sola petición en curso: no hay más datos
+
+            if (sent >= total) {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+                close(c->fd);
+                open_clients--;
+                continue;
+            }
+            if (send_next(c, max_plies) != 0) {
+                perror("send");
+                return 2;
+            }
+            if (c->pending == REQ_MOVE) sent++;
+        }
+    }
+    double elapsed = (now_ns() - t0) / 1e9;
+
+    qsort(latency, (size_t)done, sizeof(uint64_t), cmp_u64);
+    printf("%ld jugadas en %.2f s (%.0f jugadas/s), %d conexiones\n",
+           done, elapsed, elapsed > 0 ? done / elapsed : 0.0, conns);
+    printf("Latencia por jugada: p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, máx %.1f us\n",
+           percentile_us(latency, done, 0.50), percentile_us(latency, done, 0.90),
+           percentile_us(latency, done, 0.99), percentile_us(latency, done, 0.999),
+           percentile_us(latency, done, 1.0));
+    printf("Respuestas inesperadas: %ld\n", mismatches);
+
+    for (int i = 0; i < conns; i++) game_session_free(clients[i].game);
+    free(clients);
+    free(latency);
+    close(epoll_fd);
+    return mismatches ? 1 : 0;
+}
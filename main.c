@@ -1,5 +1,6 @@
 // main.c - Punto de entrada principal
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "ast.h"
@@ -8,18 +9,75 @@
 #include "semant.h"
 #include "pgn.h"
 #include "interactivo.h"
+#include "status_cache.h"
+#include "perft.h"
+#include "validate.h"
+#include "server.h"
 
 int main(int argc, char *argv[]) 
 {
+    // ----------------------------------------
+    // MODO PERFT: chess perft <profundidad> [--divide] [--validate] [--fen FEN] [SAN...]
+    // ----------------------------------------
+    if (argc >= 2 && strcmp(argv[1], "perft") == 0) {
+        return perft_mode(argc - 1, argv + 1);
+    }
+
+    // ----------------------------------------
+    // MODO VALIDATE: chess validate [--format jsonl|tsv] [--stream] [archivo.pgn ... | -]
+    // ----------------------------------------
+    if (argc >= 2 && strcmp(argv[1], "validate") == 0) {
+        return validate_mode(argc - 1, argv + 1);
+    }
+
+    // ----------------------------------------
+    // MODO SERVIDOR: chess serve [--socket RUTA | --tcp PUERTO] [--max-clients N] [--undo N]
+    // ----------------------------------------
+    if (argc >= 2 && strcmp(argv[1], "serve") == 0) {
+        return server_mode(argc - 1, argv + 1);
+    }
+
     // ----------------------------------------
     // MODO PGN (cuando se pasa archivo por argv)
     // ----------------------------------------
-    if (argc >= 2) {
+    //   chess [--compact] [--keyframes N] [--mmap] [-j N] [--no-status-cache]
+    //         [--tree [N]] [--no-game-cache] [--lazy] archivo.pgn
+    PGNOptions opts = { .jobs = 1 };
+    const char *pgn_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compact") == 0) {
+            opts.compact = 1;
+        } else if (strcmp(argv[i], "--mmap") == 0) {
+            opts.use_mmap = 1;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            opts.jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--keyframes") == 0 && i + 1 < argc) {
+            opts.keyframe_interval = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tree") == 0) {
+            // Árbol de aperturas; N = jugadas por partida (por defecto todas)
+            opts.opening_tree = 1;
+            const char *n = (i + 1 < argc) ? argv[i + 1] : "";
+            if (n[0] && strspn(n, "0123456789") == strlen(n)) {
+                opts.tree_depth = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--no-game-cache") == 0) {
+            opts.no_game_cache = 1;
+        } else if (strcmp(argv[i], "--lazy") == 0) {
+            opts.lazy = 1;
+        } else if (strcmp(argv[i], "--no-status-cache") == 0) {
+            status_cache_set_enabled(0);
+        } else {
+            pgn_path = argv[i];
+        }
+    }
+
+    if (pgn_path) {
         printf("╔════════════════════════════════════╗\n");
         printf("║          MODO ANÁLISIS PGN         ║\n");
         printf("╚════════════════════════════════════╝\n\n");
         
-        pgn_mode(argv[1]);   // NO return → permite volver al menú
+        pgn_mode_ex(pgn_path, &opts);   // NO return → permite volver al menú
     }
 
     // ----------------------------------------
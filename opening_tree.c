@@ -0,0 +1,118 @@
+// opening_tree.c - Árbol de aperturas compartido entre partidas
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opening_tree.h"
+
+static int new_node(OpeningTree *t, int parent, Move m) {
+    if (t->count >= t->capacity) {
+        int cap = t->capacity ? t->capacity * 2 : 1024;
+        OpeningNode *nodes = realloc(t->nodes, sizeof(OpeningNode) * cap);
+        if (!nodes) { perror("realloc"); exit(EXIT_FAILURE); }
+        t->nodes = nodes;
+        t->capacity = cap;
+    }
+
+    int idx = t->count++;
+    OpeningNode *n = &t->nodes[idx];
+    memset(n, 0, sizeof(*n));
+    n->move = m;
+    n->parent = parent;
+    n->first_child = -1;
+    n->next_sibling = -1;
+    n->depth = (parent >= 0) ? t->nodes[parent].depth + 1 : 0;
+
+    // Se agrega al principio de la lista de hijos del padre
+    if (parent >= 0) {
+        n->next_sibling = t->nodes[parent].first_child;
+        t->nodes[parent].first_child = idx;
+    }
+    return idx;
+}
+
+static void count_game(OpeningNode *n, OpeningResult r) {
+    n->games++;
+    if (r == OPENING_RESULT_WHITE)      n->white_wins++;
+    else if (r == OPENING_RESULT_DRAW)  n->draws++;
+    else if (r == OPENING_RESULT_BLACK) n->black_wins++;
+}
+
+void opening_tree_init(OpeningTree *t, int max_depth) {
+    memset(t, 0, sizeof(*t));
+    t->max_depth = max_depth;
+    new_node(t, -1, 0);
+}
+
+void opening_tree_free(OpeningTree *t) {
+    free(t->nodes);
+    t->nodes = NULL;
+    t->count = 0;
+    t->capacity = 0;
+}
+
+OpeningResult opening_result_from_tag(const char *result) {
+    if (!result) return OPENING_RESULT_UNKNOWN;
+    if (strcmp(result, "1-0") == 0)     return OPENING_RESULT_WHITE;
+    if (strcmp(result, "0-1") == 0)     return OPENING_RESULT_BLACK;
+    if (strcmp(result, "1/2-1/2") == 0) return OPENING_RESULT_DRAW;
+    return OPENING_RESULT_UNKNOWN;
+}
+
+int opening_tree_begin_game(OpeningTree *t, OpeningResult r) {
+    count_game(&t->nodes[OPENING_TREE_ROOT], r);
+    return OPENING_TREE_ROOT;
+}
+
+int opening_tree_child(const OpeningTree *t, int node, Move m) {
+    if (node < 0) return -1;
+    for (int c = t->nodes[node].first_child; c >= 0; c = t->nodes[c].next_sibling) {
+        if (t->nodes[c].move == m) return c;
+    }
+    return -1;
+}
+
+int opening_tree_play(OpeningTree *t, int node, Move m, OpeningResult r) {
+    if (node < 0) return -1;
+    if (t->max_depth > 0 && t->nodes[node].depth >= t->max_depth) return -1;
+
+    int child = opening_tree_child(t, node, m);
+    if (child < 0) child = new_node(t, node, m);
+    count_game(&t->nodes[child], r);
+    t->plies++;
+    return child;
+}
+
+void opening_tree_add_game(OpeningTree *t, const Move *moves, int count, OpeningResult r) {
+    int node = opening_tree_begin_game(t, r);
+    for (int i = 0; i < count && node >= 0; i++) {
+        node = opening_tree_play(t, node, moves[i], r);
+    }
+}
+
+int opening_tree_find(const OpeningTree *t, const Move *moves, int count) {
+    int node = OPENING_TREE_ROOT;
+    for (int i = 0; i < count && node >= 0; i++) {
+        node = opening_tree_child(t, node, moves[i]);
+    }
+    return node;
+}
+
+int opening_tree_depth(const OpeningTree *t, int node) {
+    return (node >= 0) ? t->nodes[node].depth : -1;
+}
+
+int opening_tree_children(const OpeningTree *t, int node, int *out, int max) {
+    int n = 0;
+    if (node < 0) return 0;
+
+    // Inserción ordenada: los nodos tienen pocos hijos
+    for (int c = t->nodes[node].first_child; c >= 0 && n < max; c = t->nodes[c].next_sibling) {
+        int i = n++;
+        while (i > 0 && t->nodes[out[i - 1]].games < t->nodes[c].games) {
+            out[i] = out[i - 1];
+            i--;
+        }
+        out[i] = c;
+    }
+    return n;
+}
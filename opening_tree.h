@@ -0,0 +1,77 @@
+// opening_tree.h - Árbol de aperturas (trie de jugadas) de una colección
+//
+// Las partidas que empiezan igual comparten los nodos de sus primeras
+// jugadas; cada nodo cuenta cuántas partidas pasaron por él y cómo
+// terminaron, así "qué se jugó en esta posición" se responde recorriendo
+// sus hijos, sin volver a leer las partidas.
+#ifndef OPENING_TREE_H
+#define OPENING_TREE_H
+
+#include "semant.h"
+
+// Resultado de una partida según su etiqueta [Result]
+typedef enum {
+    OPENING_RESULT_UNKNOWN = 0,   // "*" o sin etiqueta
+    OPENING_RESULT_WHITE,         // 1-0
+    OPENING_RESULT_DRAW,          // 1/2-1/2
+    OPENING_RESULT_BLACK          // 0-1
+} OpeningResult;
+
+// Nodo del árbol: la posición tras la jugada 'move' desde el nodo padre.
+// Los nodos viven en un array y se enlazan por índice (-1 = ninguno)
+typedef struct {
+    Move move;               // Jugada que lleva al nodo (0 en la raíz)
+    int parent;
+    int first_child;
+    int next_sibling;
+    int depth;               // Jugadas desde la raíz
+    int games;               // Partidas que pasaron por el nodo
+    int white_wins;
+    int draws;
+    int black_wins;
+} OpeningNode;
+
+// La raíz (posición inicial) es siempre el nodo 0
+#define OPENING_TREE_ROOT 0
+
+typedef struct {
+    OpeningNode *nodes;
+    int count;
+    int capacity;
+    int max_depth;           // Jugadas de cada partida que se insertan (0 = todas)
+    long plies;              // Jugadas insertadas (con repeticiones)
+} OpeningTree;
+
+// Crea el árbol solo con la raíz
+void opening_tree_init(OpeningTree *t, int max_depth);
+
+// Libera los nodos
+void opening_tree_free(OpeningTree *t);
+
+// Convierte el valor de la etiqueta [Result]
+OpeningResult opening_result_from_tag(const char *result);
+
+// Cuenta una partida nueva en la raíz; devuelve OPENING_TREE_ROOT
+int opening_tree_begin_game(OpeningTree *t, OpeningResult r);
+
+// Baja desde 'node' por la jugada 'm' (creando el hijo si no existe) y
+// cuenta la partida en él. Devuelve el hijo, o -1 si se superó max_depth
+int opening_tree_play(OpeningTree *t, int node, Move m, OpeningResult r);
+
+// Inserta las jugadas de una partida completa
+void opening_tree_add_game(OpeningTree *t, const Move *moves, int count, OpeningResult r);
+
+// Hijo de 'node' por la jugada 'm', o -1 si nunca se jugó
+int opening_tree_child(const OpeningTree *t, int node, Move m);
+
+// Nodo al que se llega con 'count' jugadas desde la raíz, o -1
+int opening_tree_find(const OpeningTree *t, const Move *moves, int count);
+
+// Profundidad del nodo (jugadas desde la raíz)
+int opening_tree_depth(const OpeningTree *t, int node);
+
+// Hijos de 'node' ordenados por cantidad de partidas (de más a menos).
+// Devuelve cuántos escribió en 'out' (como máximo 'max')
+int opening_tree_children(const OpeningTree *t, int node, int *out, int max);
+
+#endif // OPENING_TREE_H
@@ -238,3 +238,194 @@ int parse_move(const TokenList *tokens, MoveAST *out) {
     // no debería llegar aquí
     return -1;
 }
+
+// ============================================================================
+// SAN_PARSE: LEXER + PARSER EN UNA PASADA
+// ============================================================================
+//
+// Autómata guiado por tablas equivalente a tokenize + parse_move: acepta y
+// rechaza exactamente lo mismo, pero recorre el texto una sola vez, sin
+// construir la lista de tokens ni reservar memoria.
+
+// Clase de cada carácter (equivale al token que generaría el lexer)
+enum {
+    SC_OTHER = 0,   // TK_UNKNOWN
+    SC_SPACE,       // se ignora
+    SC_FILE,        // a-h
+    SC_RANK,        // 1-8
+    SC_PIECE,       // Q R B N (pieza o pieza de promoción)
+    SC_KING,        // K (nunca es pieza de promoción)
+    SC_CAPTURE,     // x X
+    SC_PROMOTE,     // =
+    SC_CHECK,       // +
+    SC_MATE,        // #
+    SC_CASTLE,      // O 0 (inicio de enroque)
+    SC_COUNT
+};
+
+static const unsigned char san_class[256] = {
+    [' '] = SC_SPACE, ['\t'] = SC_SPACE, ['\n'] = SC_SPACE,
+    ['\v'] = SC_SPACE, ['\f'] = SC_SPACE, ['\r'] = SC_SPACE,
+    ['a'] = SC_FILE, ['b'] = SC_FILE, ['c'] = SC_FILE, ['d'] = SC_FILE,
+    ['e'] = SC_FILE, ['f'] = SC_FILE, ['g'] = SC_FILE, ['h'] = SC_FILE,
+    ['1'] = SC_RANK, ['2'] = SC_RANK, ['3'] = SC_RANK, ['4'] = SC_RANK,
+    ['5'] = SC_RANK, ['6'] = SC_RANK, ['7'] = SC_RANK, ['8'] = SC_RANK,
+    ['Q'] = SC_PIECE, ['R'] = SC_PIECE, ['B'] = SC_PIECE, ['N'] = SC_PIECE,
+    ['K'] = SC_KING,
+    ['x'] = SC_CAPTURE, ['X'] = SC_CAPTURE,
+    ['='] = SC_PROMOTE,
+    ['+'] = SC_CHECK,
+    ['#'] = SC_MATE,
+    ['O'] = SC_CASTLE, ['0'] = SC_CASTLE,
+};
+
+// Estados. S_ERR = 0 para que toda transición no listada sea un error.
+// Nombres: P = pieza, F = columna, R = fila, X = captura.
+enum {
+    S_ERR = 0,
+    S_START,
+    // Movimiento de pieza
+    S_P, S_PF, S_PFR, S_PFRF, S_PFRX, S_PFRXF, S_PFF, S_PFX, S_PFXF,
+    S_PR, S_PRX, S_PRXF, S_PRF, S_PX, S_PXF,
+    // Movimiento de peón
+    S_F, S_FX, S_FXF,
+    // Sufijos
+    S_DONE,         // casilla destino completa
+    S_PROMO,        // tras '='
+    S_PROMO_DONE,   // tras '=' y pieza (o un espacio tras '=')
+    S_CHECK,
+    S_MATE,
+    S_CASTLE,       // tras O-O / O-O-O
+    S_COUNT
+};
+
+// Sufijo común: promoción opcional, luego + y # opcionales (en ese orden)
+#define SAN_SUFFIX \
+    [SC_PROMOTE] = S_PROMO, [SC_CHECK] = S_CHECK, [SC_MATE] = S_MATE
+
+static const unsigned char san_dfa[S_COUNT][SC_COUNT] = {
+    [S_START]  = { [SC_SPACE] = S_START, [SC_FILE] = S_F,
+                   [SC_PIECE] = S_P, [SC_KING] = S_P },
+
+    [S_P]      = { [SC_SPACE] = S_P, [SC_FILE] = S_PF, [SC_RANK] = S_PR,
+                   [SC_CAPTURE] = S_PX },
+    [S_PF]     = { [SC_SPACE] = S_PF, [SC_RANK] = S_PFR, [SC_FILE] = S_PFF,
+                   [SC_CAPTURE] = S_PFX },
+    [S_PFR]    = { SAN_SUFFIX, [SC_SPACE] = S_PFR, [SC_FILE] = S_PFRF,
+                   [SC_CAPTURE] = S_PFRX },
+    [S_PFRF]   = { [SC_SPACE] = S_PFRF, [SC_RANK] = S_DONE },
+    [S_PFRX]   = { [SC_SPACE] = S_PFRX, [SC_FILE] = S_PFRXF },
+    [S_PFRXF]  = { [SC_SPACE] = S_PFRXF, [SC_RANK] = S_DONE },
+    [S_PFF]    = { [SC_SPACE] = S_PFF, [SC_RANK] = S_DONE },
+    [S_PFX]    = { [SC_SPACE] = S_PFX, [SC_FILE] = S_PFXF },
+    [S_PFXF]   = { [SC_SPACE] = S_PFXF, [SC_RANK] = S_DONE },
+    [S_PR]     = { [SC_SPACE] = S_PR, [SC_CAPTURE] = S_PRX, [SC_FILE] = S_PRF },
+    [S_PRX]    = { [SC_SPACE] = S_PRX, [SC_FILE] = S_PRXF },
+    [S_PRXF]   = { [SC_SPACE] = S_PRXF, [SC_RANK] = S_DONE },
+    [S_PRF]    = { [SC_SPACE] = S_PRF, [SC_RANK] = S_DONE },
+    [S_PX]     = { [SC_SPACE] = S_PX, [SC_FILE] = S_PXF },
+    [S_PXF]    = { [SC_SPACE] = S_PXF, [SC_RANK] = S_DONE },
+
+    [S_F]      = { [SC_SPACE] = S_F, [SC_RANK] = S_DONE, [SC_CAPTURE] = S_FX },
+    [S_FX]     = { [SC_SPACE] = S_FX, [SC_FILE] = S_FXF },
+    [S_FXF]    = { [SC_SPACE] = S_FXF, [SC_RANK] = S_DONE },
+
+    [S_DONE]   = { SAN_SUFFIX, [SC_SPACE] = S_DONE },
+    // El lexer solo une '=' con la pieza siguiente si van pegados
+    [S_PROMO]  = { [SC_SPACE] = S_PROMO_DONE, [SC_PIECE] = S_PROMO_DONE,
+                   [SC_CHECK] = S_CHECK, [SC_MATE] = S_MATE },
+    [S_PROMO_DONE] = { [SC_SPACE] = S_PROMO_DONE, [SC_CHECK] = S_CHECK, [SC_MATE] = S_MATE },
+    [S_CHECK]  = { [SC_SPACE] = S_CHECK, [SC_MATE] = S_MATE },
+    [S_MATE]   = { [SC_SPACE] = S_MATE },
+    [S_CASTLE] = { [SC_SPACE] = S_CASTLE, [SC_CHECK] = S_CHECK, [SC_MATE] = S_MATE },
+};
+
+// Estados en los que la jugada puede terminar
+static const unsigned char san_accept[S_COUNT] = {
+    [S_PFR] = 1, [S_DONE] = 1, [S_PROMO] = 1, [S_PROMO_DONE] = 1,
+    [S_CHECK] = 1, [S_MATE] = 1, [S_CASTLE] = 1,
+};
+
+// Compara "O-O" / "O-O-O" en s[i..], aceptando '0' en lugar de 'O'
+static int san_match_castle(const char *s, size_t len, size_t i, size_t plen) {
+    if (i + plen > len) return 0;
+    for (size_t j = 0; j < plen; ++j) {
+        char c = s[i + j];
+        if (j % 2 == 1) { if (c != '-') return 0; }
+        else if (c != 'O' && c != '0') return 0;
+    }
+    return 1;
+}
+
+int san_parse(const char *s, size_t len, MoveAST *out) {
+    memset(out, 0, sizeof(*out));
+
+    int state = S_START;
+    size_t raw_len = 0;
+    char file = 0, rank = 0;   // última columna y fila leídas (destino)
+
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = (unsigned char)s[i];
+        int cls = san_class[c];
+
+        if (cls == SC_CASTLE) {
+            // Igual que el lexer: primero O-O-O, luego O-O
+            if (state != S_START) return -2;
+            size_t plen = san_match_castle(s, len, i, 5) ? 5
+                        : san_match_castle(s, len, i, 3) ? 3 : 0;
+            if (plen == 0) return -2;
+            if (plen == 5) out->is_castle_long = 1;
+            else out->is_castle_short = 1;
+            memcpy(out->raw, "O-O-O", plen);
+            raw_len = plen;
+            i += plen - 1;
+            state = S_CASTLE;
+            continue;
+        }
+
+        int next = san_dfa[state][cls];
+        if (next == S_ERR) return -2;
+
+        switch (cls) {
+            case SC_SPACE:
+                break;
+            case SC_FILE:
+                if (file) out->src_file = file;   // la anterior era desambiguación
+                file = (char)c;
+                break;
+            case SC_RANK:
+                if (rank) out->src_rank = rank;
+                rank = (char)c;
+                break;
+            case SC_PIECE:
+            case SC_KING:
+                if (state == S_START) out->piece = (char)c;
+                else out->promotion = (char)c;
+                break;
+            case SC_CAPTURE:
+                out->is_capture = 1;
+                c = 'x';
+                break;
+            case SC_CHECK:
+                out->is_check = 1;
+                break;
+            case SC_MATE:
+                out->is_mate = 1;
+                break;
+        }
+
+        if (cls != SC_SPACE && raw_len < sizeof(out->raw) - 1) out->raw[raw_len++] = (char)c;
+        state = next;
+    }
+
+    if (state == S_START) return -1;   // sin jugada (el lexer la rechaza)
+    if (!san_accept[state]) return -2;
+
+    out->raw[raw_len] = '\0';
+    if (!out->is_castle_short && !out->is_castle_long) {
+        if (!out->piece) out->piece = 'P';
+        out->dest_file = file;
+        out->dest_rank = rank;
+    }
+    return 0;
+}
@@ -7,4 +7,11 @@
 // Devuelve 0 en éxito, -1 en error de parseo (y escribe motivo en stderr).
 int parse_move(const TokenList *tokens, MoveAST *out);
 
+// Lexer y parser en una sola pasada, sin reservar memoria ni escribir en
+// stderr: acepta las mismas jugadas que tokenize + parse_move y deja el
+// mismo MoveAST. 's' no necesita terminar en '\0'.
+// Devuelve 0 en éxito, -1 si no hay jugada (error léxico) y -2 si no es
+// SAN válida (error sintáctico).
+int san_parse(const char *s, size_t len, MoveAST *out);
+
 #endif // PARSER_H
@@ -0,0 +1,208 @@
+// perft.c - Conteo de nodos (perft) y benchmark del generador de jugadas
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ast.h"
+#include "parser.h"
+#include "semant.h"
+#include "perft.h"
+
+// Valores de referencia desde la posición inicial (profundidad 1 a 7)
+static const uint64_t start_perft[] = {
+    1, 20, 400, 8902, 197281, 4865609, 119060324, 3195901860ULL
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static Color opposite(Color c) {
+    return (c == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+}
+
+uint64_t perft(Board *b, Color side, int depth) {
+    if (depth <= 0) return 1;
+
+    MoveList list;
+    int n = board_generate_legal_moves(b, side, &list);
+    if (depth == 1) return (uint64_t)n;   // Conteo directo en el último nivel
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < n; i++) {
+        MoveUndo undo;
+        board_make_move(b, list.moves[i], &undo);
+        nodes += perft(b, opposite(side), depth - 1);
+        board_unmake_move(b, &undo);
+    }
+    return nodes;
+}
+
+// ============================================================================
+// VALIDACIÓN CRUZADA CON LA RUTA SAN
+// ============================================================================
+//
+// Cada jugada generada se escribe en SAN, se vuelve a leer con san_parse y
+// se aplica con board_apply_move_ex, como al cargar un PGN. Las dos rutas
+// deben dar el mismo movimiento; así perft también mide y comprueba la
+// validación de reglas.
+
+typedef struct {
+    long checked;
+    long errors;
+} ValidateStats;
+
+// 0 si la ruta SAN reproduce la jugada 'm'
+static int validate_move(Board *b, Color side, Move m, ValidateStats *vs) {
+    char san[16];
+    char err[256] = {0};
+    MoveAST ast;
+    Move code = 0;
+    Board copy = *b;
+
+    vs->checked++;
+    board_move_to_san(b, m, san, sizeof(san));
+    if (san_parse(san, strlen(san), &ast) == 0 &&
+        board_apply_move_ex(&copy, &ast, side, &code, err, sizeof(err)) == 0 &&
+        code == m) {
+        return 0;
+    }
+
+    if (vs->errors++ < 10) {
+        fprintf(stderr, "❌ La ruta SAN no reproduce %s: %s\n", san,
+                err[0] ? err : "movimiento distinto");
+    }
+    return -1;
+}
+
+static uint64_t perft_validate(Board *b, Color side, int depth, ValidateStats *vs) {
+    if (depth <= 0) return 1;
+
+    MoveList list;
+    int n = board_generate_legal_moves(b, side, &list);
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < n; i++) {
+        validate_move(b, side, list.moves[i], vs);
+        if (depth == 1) {
+            nodes++;
+            continue;
+        }
+        MoveUndo undo;
+        board_make_move(b, list.moves[i], &undo);
+        nodes += perft_validate(b, opposite(side), depth - 1, vs);
+        board_unmake_move(b, &undo);
+    }
+    return nodes;
+}
+
+// ============================================================================
+// MODO PERFT
+// ============================================================================
+
+static void perft_usage(void) {
+    printf("Uso: chess perft <profundidad> [--divide] [--validate] [--fen FEN] [jugadas SAN...]\n");
+    printf("  --divide    Nodos bajo cada jugada de la posición\n");
+    printf("  --validate  Comprueba cada jugada también por la ruta SAN (más lento)\n");
+    printf("  --fen FEN   Cuenta desde la posición FEN en lugar de la inicial\n");
+    printf("  Las jugadas SAN se aplican (desde la posición inicial o el FEN) antes de contar\n");
+}
+
+int perft_mode(int argc, char *argv[]) {
+    int depth = -1;
+    int divide = 0, validate = 0;
+    int from_start = 1;
+
+    Board board;
+    board_init_start(&board);
+    Color side = COLOR_WHITE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--divide") == 0) {
+            divide = 1;
+        } else if (strcmp(argv[i], "--validate") == 0) {
+            validate = 1;
+        } else if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc) {
+            if (board_from_fen(&board, argv[++i], &side, NULL, NULL) != 0) {
+                fprintf(stderr, "FEN inválido: %s\n", argv[i]);
+                return 1;
+            }
+            from_start = 0;
+        } else if (depth < 0) {
+            depth = atoi(argv[i]);
+        } else {
+            // Jugada SAN previa al conteo
+            MoveAST ast;
+            char err[256] = {0};
+            if (san_parse(argv[i], strlen(argv[i]), &ast) != 0 ||
+                board_apply_move_ex(&board, &ast, side, NULL, err, sizeof(err)) != 0) {
+                fprintf(stderr, "Jugada inválida '%s': %s\n", argv[i],
+                        err[0] ? err : "no cumple la notación SAN");
+                return 1;
+            }
+            side = opposite(side);
+            from_start = 0;
+        }
+    }
+
+    if (depth < 1) {
+        perft_usage();
+        return 1;
+    }
+
+    char fen[BOARD_FEN_MAX];
+    board_to_fen(&board, side, 0, 1, fen, sizeof(fen));
+    printf("Posición: %s\n", fen);
+    printf("Perft %s, profundidad %d (juegan las %s)\n",
+           from_start ? "desde la posición inicial" : "desde la posición dada",
+           depth, side == COLOR_WHITE ? "blancas" : "negras");
+
+    ValidateStats vs = { 0, 0 };
+    uint64_t total = 0;
+    double t0 = now_seconds();
+
+    if (divide) {
+        MoveList list;
+        int n = board_generate_legal_moves(&board, side, &list);
+        for (int i = 0; i < n; i++) {
+            char san[16];
+            MoveUndo undo;
+            board_move_to_san(&board, list.moves[i], san, sizeof(san));
+            if (validate) validate_move(&board, side, list.moves[i], &vs);
+
+            board_make_move(&board, list.moves[i], &undo);
+            uint64_t nodes = validate ? perft_validate(&board, opposite(side), depth - 1, &vs)
+                                      : perft(&board, opposite(side), depth - 1);
+            board_unmake_move(&board, &undo);
+
+            printf("  %-8s %llu\n", san, (unsigned long long)nodes);
+            total += nodes;
+        }
+        printf("Jugadas: %d\n", n);
+    } else {
+        total = validate ? perft_validate(&board, side, depth, &vs)
+                         : perft(&board, side, depth);
+    }
+
+    double elapsed = now_seconds() - t0;
+    printf("Nodos:   %llu\n", (unsigned long long)total);
+    printf("Tiempo:  %.3f s (%.2f Mnodos/s)\n", elapsed,
+           elapsed > 0 ? total / elapsed / 1e6 : 0.0);
+
+    int ok = 1;
+    if (validate) {
+        printf("Ruta SAN: %ld jugadas comprobadas, %ld errores\n", vs.checked, vs.errors);
+        if (vs.errors) ok = 0;
+    }
+    if (from_start && depth < (int)(sizeof(start_perft) / sizeof(start_perft[0]))) {
+        if (total == start_perft[depth]) {
+            printf("✓ Coincide con el valor de referencia\n");
+        } else {
+            printf("❌ Valor de referencia: %llu\n", (unsigned long long)start_perft[depth]);
+            ok = 0;
+        }
+    }
+    return ok ? 0 : 1;
+}
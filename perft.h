@@ -0,0 +1,20 @@
+// perft.h - Conteo de nodos del árbol de jugadas (perft)
+//
+// Recorre todas las jugadas legales hasta una profundidad y cuenta las
+// posiciones finales. Sirve para comprobar el generador de jugadas contra
+// valores conocidos y para medir su velocidad (nodos por segundo).
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <stdint.h>
+#include "semant.h"
+
+// Posiciones finales a 'depth' jugadas de 'b' (el tablero queda igual)
+uint64_t perft(Board *b, Color side, int depth);
+
+// Modo perft de la línea de comandos:
+//   chess perft <profundidad> [--divide] [--validate] [jugadas SAN...]
+// Retorna 0 si el conteo (y la validación) es correcto, 1 si no
+int perft_mode(int argc, char *argv[]);
+
+#endif // PERFT_H
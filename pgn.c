@@ -3,57 +3,24 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <sched.h>
 #include "ast.h"
-#include "lexer.h"
 #include "parser.h"
 #include "semant.h"
 #include "pgn.h"
+#include "pgn_reader.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include "arena.h"
+#include "status_cache.h"
+#include "game_cache.h"
 
 // ============================================================================
 // FUNCIONES AUXILIARES
 // ============================================================================
 
-static int is_result_token(const char *s) {
-    return (strcmp(s, "1-0") == 0 ||
-            strcmp(s, "0-1") == 0 ||
-            strcmp(s, "1/2-1/2") == 0 ||
-            strcmp(s, "*") == 0);
-}
-
-static char *clean_pgn_text(const char *input) {
-    size_t n = strlen(input);
-    char *out = malloc(n + 1);
-    if (!out) return NULL;
-    
-    size_t j = 0;
-    int brace = 0, paren = 0;
-    
-    for (size_t i = 0; i < n; ++i) {
-        char c = input[i];
-        
-        if (c == '{') { brace = 1; continue; }
-        if (c == '}') { brace = 0; continue; }
-        if (c == '(') { paren = 1; continue; }
-        if (c == ')') { paren = 0; continue; }
-        
-        if (brace || paren) continue;
-        
-        if (isdigit((unsigned char)c)) {
-            size_t k = i;
-            while (k < n && isdigit((unsigned char)input[k])) k++;
-            if (k < n && input[k] == '.') {
-                while (k < n && input[k] == '.') k++;
-                i = k - 1;
-                continue;
-            }
-        }
-        
-        out[j++] = c;
-    }
-    out[j] = '\0';
-    return out;
-}
-
 static void trim(char *s) {
     if (!s) return;
     
@@ -76,8 +43,11 @@ static void trim(char *s) {
 
 void pgn_game_init(PGNGame *game) {
     memset(game, 0, sizeof(PGNGame));
-    game->move_capacity = 100;
-    game->moves = malloc(sizeof(GameMove) * game->move_capacity);
+}
+
+void pgn_game_init_compact(PGNGame *game, int keyframe_interval) {
+    memset(game, 0, sizeof(PGNGame));
+    game->keyframe_interval = keyframe_interval;
 }
 
 void pgn_game_free(PGNGame *game) {
@@ -85,12 +55,22 @@ void pgn_game_free(PGNGame *game) {
         free(game->moves);
         game->moves = NULL;
     }
+    if (game->codes) {
+        free(game->codes);
+        game->codes = NULL;
+    }
+    if (game->keyframes) {
+        free(game->keyframes);
+        game->keyframes = NULL;
+    }
 }
 
 void pgn_collection_init(PGNCollection *col) {
     col->game_capacity = 10;
     col->game_count = 0;
     col->games = malloc(sizeof(PGNGame) * col->game_capacity);
+    memset(&col->tree, 0, sizeof(col->tree));
+    tag_index_init(&col->tags);
 }
 
 void pgn_collection_free(PGNCollection *col) {
@@ -98,68 +78,171 @@ void pgn_collection_free(PGNCollection *col) {
         pgn_game_free(&col->games[i]);
     }
     free(col->games);
+    opening_tree_free(&col->tree);
+    tag_index_free(&col->tags);
 }
 
-static void pgn_game_add_move(PGNGame *game, const char *move_text, 
+// Durante la validación los arrays de la partida viven en la arena del hilo;
+// pgn_game_detach los copia al heap con su tamaño final
+static void pgn_game_add_move(PGNGame *game, Arena *arena,
+                              const char *move_text, size_t move_len,
                               const MoveAST *ast, const Board *board, 
-                              Color side) {
+                              Color side, Move code) {
     if (game->move_count >= game->move_capacity) {
-        game->move_capacity *= 2;
-        game->moves = realloc(game->moves, sizeof(GameMove) * game->move_capacity);
+        int old_cap = game->move_capacity;
+        game->move_capacity = old_cap ? old_cap * 2 : 128;
+        if (game->keyframe_interval > 0) {
+            game->codes = arena_realloc(arena, game->codes, sizeof(Move) * old_cap,
+                                        sizeof(Move) * game->move_capacity);
+        } else {
+            game->moves = arena_realloc(arena, game->moves, sizeof(GameMove) * old_cap,
+                                        sizeof(GameMove) * game->move_capacity);
+        }
+    }
+
+    if (game->keyframe_interval > 0) {
+        game->codes[game->move_count++] = code;
+
+        // Tablero clave cada keyframe_interval jugadas
+        if (game->move_count % game->keyframe_interval == 0) {
+            int k = game->move_count / game->keyframe_interval;
+            game->keyframes = arena_realloc(arena, game->keyframes, sizeof(Board) * (k - 1),
+                                            sizeof(Board) * k);
+            game->keyframes[k - 1] = *board;
+        }
+        return;
     }
     
     GameMove *gm = &game->moves[game->move_count++];
-    strncpy(gm->move_text, move_text, sizeof(gm->move_text) - 1);
+    if (move_len > sizeof(gm->move_text) - 1) move_len = sizeof(gm->move_text) - 1;
+    memcpy(gm->move_text, move_text, move_len);
+    gm->move_text[move_len] = '\0';
     gm->ast = *ast;
     gm->board_state = *board;
     gm->side_to_move = side;
+    gm->code = code;
+}
+
+// Copia un array de la arena al heap
+static void *heap_copy(const void *src, size_t size) {
+    if (!src || size == 0) return NULL;
+    void *dst = malloc(size);
+    if (!dst) { perror("malloc"); exit(EXIT_FAILURE); }
+    memcpy(dst, src, size);
+    return dst;
+}
+
+// Pasa los arrays de la partida de la arena al heap, con su tamaño final
+static void pgn_game_detach(PGNGame *game) {
+    game->moves = heap_copy(game->moves, sizeof(GameMove) * game->move_count);
+    game->codes = heap_copy(game->codes, sizeof(Move) * game->move_count);
+    if (game->keyframe_interval > 0) {
+        game->keyframes = heap_copy(game->keyframes,
+                                    sizeof(Board) * (game->move_count / game->keyframe_interval));
+    }
+    game->move_capacity = game->move_count;
+}
+
+// Descarta los arrays que apuntan a la arena (partida inválida)
+static void pgn_game_drop_moves(PGNGame *game) {
+    game->moves = NULL;
+    game->codes = NULL;
+    game->keyframes = NULL;
+    game->move_count = 0;
+    game->move_capacity = 0;
+}
+
+// Posición inicial de la partida: la estándar o la de su etiqueta [FEN]
+// (ya validada al cargarla)
+static void pgn_game_start_board(const PGNGame *game, Board *out) {
+    if (!game->fen[0] || board_from_fen(out, game->fen, NULL, NULL, NULL) != 0) {
+        board_init_start(out);
+    }
+}
+
+void pgn_game_board_at(const PGNGame *game, int ply, Board *out) {
+    if (ply > game->move_count) ply = game->move_count;
+
+    if (ply <= 0) {
+        pgn_game_start_board(game, out);
+        return;
+    }
+
+    if (game->keyframe_interval <= 0) {
+        *out = game->moves[ply - 1].board_state;
+        return;
+    }
+
+    // Partir del tablero clave más cercano y aplicar los códigos restantes
+    int k = ply / game->keyframe_interval;
+    int start = k * game->keyframe_interval;
+    if (k > 0) {
+        *out = game->keyframes[k - 1];
+    } else {
+        pgn_game_start_board(game, out);
+    }
+
+    for (int i = start; i < ply; i++) {
+        MoveUndo undo;
+        board_make_move(out, game->codes[i], &undo);
+    }
+}
+
+// Color que hizo la jugada 'idx' (0 = primera jugada)
+static Color pgn_game_move_side(const PGNGame *game, int idx) {
+    if (game->keyframe_interval <= 0) return game->moves[idx].side_to_move;
+    Color first = (game->start_side == COLOR_BLACK) ? COLOR_BLACK : COLOR_WHITE;
+    Color second = (first == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    return (idx % 2 == 0) ? first : second;
+}
+
+// Codificación de 16 bits de la jugada 'idx'
+static Move pgn_game_move_code(const PGNGame *game, int idx) {
+    if (game->keyframe_interval <= 0) return game->moves[idx].code;
+    return game->codes[idx];
+}
+
+// Texto SAN de la jugada 'idx'; en modo compacto se regenera desde la posición
+static void pgn_game_move_text(const PGNGame *game, int idx, char *out, size_t out_size) {
+    if (game->keyframe_interval <= 0) {
+        snprintf(out, out_size, "%s", game->moves[idx].move_text);
+        return;
+    }
+    Board before;
+    pgn_game_board_at(game, idx, &before);
+    board_move_to_san(&before, game->codes[idx], out, out_size);
 }
 
 // ============================================================================
 // PARSING DE HEADERS
 // ============================================================================
 
-static void parse_pgn_header(const char *line, PGNGame *game) {
-    if (strncmp(line, "[Event ", 7) == 0) {
-        const char *start = strchr(line, '"');
-        const char *end = start ? strrchr(line, '"') : NULL;
-        if (start && end && end > start) {
-            int len = end - start - 1;
-            if (len > 0 && len < 255) {
-                strncpy(game->event, start + 1, len);
-                game->event[len] = '\0';
-            }
-        }
-    } else if (strncmp(line, "[White ", 7) == 0) {
-        const char *start = strchr(line, '"');
-        const char *end = start ? strrchr(line, '"') : NULL;
-        if (start && end && end > start) {
-            int len = end - start - 1;
-            if (len > 0 && len < 127) {
-                strncpy(game->white, start + 1, len);
-                game->white[len] = '\0';
-            }
-        }
-    } else if (strncmp(line, "[Black ", 7) == 0) {
-        const char *start = strchr(line, '"');
-        const char *end = start ? strrchr(line, '"') : NULL;
-        if (start && end && end > start) {
-            int len = end - start - 1;
-            if (len > 0 && len < 127) {
-                strncpy(game->black, start + 1, len);
-                game->black[len] = '\0';
-            }
-        }
-    } else if (strncmp(line, "[Result ", 8) == 0) {
-        const char *start = strchr(line, '"');
-        const char *end = start ? strrchr(line, '"') : NULL;
-        if (start && end && end > start) {
-            int len = end - start - 1;
-            if (len > 0 && len < 15) {
-                strncpy(game->result, start + 1, len);
-                game->result[len] = '\0';
-            }
-        }
+// Copia el valor de una etiqueta si cabe en el campo destino
+static void copy_tag_value(char *dst, size_t dst_size, PGNView value) {
+    if (value.ptr && value.len > 0 && value.len < dst_size - 1) {
+        memcpy(dst, value.ptr, value.len);
+        dst[value.len] = '\0';
+    }
+}
+
+static int tag_is(PGNView name, const char *key) {
+    size_t n = strlen(key);
+    return name.len == n && memcmp(name.ptr, key, n) == 0;
+}
+
+static void parse_pgn_header(PGNView name, PGNView value, PGNGame *game) {
+    if (tag_is(name, "Event")) {
+        copy_tag_value(game->event, sizeof(game->event), value);
+    } else if (tag_is(name, "White")) {
+        copy_tag_value(game->white, sizeof(game->white), value);
+    } else if (tag_is(name, "Black")) {
+        copy_tag_value(game->black, sizeof(game->black), value);
+    } else if (tag_is(name, "Result")) {
+        copy_tag_value(game->result, sizeof(game->result), value);
+    } else if (tag_is(name, "FEN")) {
+        // Posición inicial; se valida junto con las jugadas. [SetUp "1"]
+        // solo anuncia esta etiqueta, así que basta con leer el FEN
+        copy_tag_value(game->fen, sizeof(game->fen), value);
     }
 }
 
@@ -167,170 +250,1089 @@ static void parse_pgn_header(const char *line, PGNGame *game) {
 // VALIDACIÓN Y CARGA DE PARTIDAS
 // ============================================================================
 
-static int validate_and_load_game(PGNGame *game, const char *moves_buffer, int game_number) {
+// Tamaño de bloque de la arena de cada hilo (una partida típica cabe en uno)
+#define PGN_ARENA_BLOCK (256 * 1024)
+
+// Mensajes de error de una partida. Con log == NULL se escriben directo en
+// stderr; en la validación en paralelo se acumulan para imprimirlos en el
+// orden de las partidas.
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} ErrorLog;
+
+static void error_log_printf(ErrorLog *log, const char *fmt, ...) {
+    va_list ap;
+    if (!log) {
+        va_start(ap, fmt);
+        vfprintf(stderr, fmt, ap);
+        va_end(ap);
+        return;
+    }
+
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+
+    if (log->len + (size_t)n + 1 > log->cap) {
+        size_t cap = log->cap ? log->cap : 256;
+        while (cap < log->len + (size_t)n + 1) cap *= 2;
+        char *data = realloc(log->data, cap);
+        if (!data) return;
+        log->data = data;
+        log->cap = cap;
+    }
+
+    va_start(ap, fmt);
+    vsnprintf(log->data + log->len, log->cap - log->len, fmt, ap);
+    va_end(ap);
+    log->len += (size_t)n;
+}
+
+// Valida las jugadas de 'movetext' (vista sobre el texto de la partida,
+// sin copiarlo) desde la posición de game->fen. Con 'store' las agrega a
+// 'game'; las reservas temporales salen de 'arena', que se reinicia al
+// empezar cada partida. Si la partida es inválida describe el error en 'err'.
+static int check_game_moves(PGNGame *game, PGNView movetext, Arena *arena, int store,
+                            PGNGameError *err) {
     Board board;
-    board_init_start(&board);
     Color side = COLOR_WHITE;
+    int halfmove = 0;
     int move_num = 0;
     
-    char *clean = clean_pgn_text(moves_buffer);
-    if (!clean) {
-        fprintf(stderr, "❌ Partida #%d: Error al limpiar texto PGN\n", game_number);
+    memset(err, 0, sizeof(*err));
+    if (!game->fen[0]) {
+        board_init_start(&board);
+    } else if (board_from_fen(&board, game->fen, &side, &halfmove, NULL) != 0) {
+        err->kind = PGN_ERROR_FEN;
+        snprintf(err->reason, sizeof(err->reason), "FEN inválido: '%s'", game->fen);
         return -1;
     }
+    game->start_side = side;
     
-    char *tok = strtok(clean, " \t\r\n");
-    while (tok) {
-        if (is_result_token(tok)) break;
+    // Claves de las posiciones para detectar repeticiones y la regla de 50
+    PositionHistory history;
+    history_init(&history, &board);
+    history.halfmove_clock = halfmove;
+    
+    if (store) arena_reset(arena);
+    
+    PGNScanner scanner;
+    PGNToken tok;
+    pgn_scanner_init(&scanner, movetext);
+    
+    while (pgn_scanner_next(&scanner, &tok) != PGN_TOKEN_END) {
+        if (tok.kind == PGN_TOKEN_RESULT) break;
+        if (tok.kind != PGN_TOKEN_SAN) continue;   // comentarios y variantes
         
         move_num++;
+        err->ply = move_num;
+        err->move = tok.text;
         
-        TokenList tl;
-        if (tokenize(tok, &tl) != 0) {
-            fprintf(stderr, "❌ Partida #%d - ERROR LÉXICO en movimiento %d: '%s'\n", 
-                    game_number, move_num, tok);
-            fprintf(stderr, "   La partida no será cargada.\n");
-            free(clean);
-            return -1;
-        }
-        
+        // Lexer y parser en una pasada, sin lista de tokens
         MoveAST ast;
-        if (parse_move(&tl, &ast) != 0) {
-            fprintf(stderr, "❌ Partida #%d - ERROR SINTÁCTICO en movimiento %d: '%s'\n", 
-                    game_number, move_num, tok);
-            fprintf(stderr, "   El movimiento no cumple con la notación SAN estándar.\n");
-            tokenlist_free(&tl);
-            free(clean);
+        int perr = san_parse(tok.text.ptr, tok.text.len, &ast);
+        if (perr != 0) {
+            err->kind = (perr == -1) ? PGN_ERROR_LEXICAL : PGN_ERROR_SYNTAX;
+            snprintf(err->reason, sizeof(err->reason), "%s",
+                     perr == -1 ? "Símbolo no reconocido en la jugada."
+                                : "El movimiento no cumple con la notación SAN estándar.");
+            if (store) pgn_game_drop_moves(game);
             return -1;
         }
         
-        char err[256] = {0};
-        if (board_apply_move(&board, &ast, side, err, sizeof(err)) != 0) {
-            fprintf(stderr, "❌ Partida #%d - ERROR SEMÁNTICO en movimiento %d: '%s'\n", 
-                    game_number, move_num, tok);
-            fprintf(stderr, "   Razón: %s\n", err);
-            fprintf(stderr, "   La partida no será cargada.\n");
-            tokenlist_free(&tl);
-            free(clean);
+        Move code = 0;
+        if (board_apply_move_ex(&board, &ast, side, &code,
+                                err->reason, sizeof(err->reason)) != 0) {
+            err->kind = PGN_ERROR_SEMANTIC;
+            if (store) pgn_game_drop_moves(game);
             return -1;
         }
         
-        pgn_game_add_move(game, tok, &ast, &board, side);
+        if (store) pgn_game_add_move(game, arena, tok.text.ptr, tok.text.len, &ast, &board, side, code);
+        history_push(&history, &board);
         side = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
-        
-        tokenlist_free(&tl);
-        tok = strtok(NULL, " \t\r\n");
     }
     
-    free(clean);
-    
+    err->ply = 0;
+    err->move.ptr = NULL;
+    err->move.len = 0;
     if (move_num == 0) {
-        fprintf(stderr, "❌ Partida #%d: No contiene movimientos válidos\n", game_number);
+        err->kind = PGN_ERROR_EMPTY;
+        snprintf(err->reason, sizeof(err->reason), "No contiene movimientos válidos");
         return -1;
     }
     
+    game->move_count = move_num;
+    game->final_status = history_evaluate_status(&history, &board, side);
+    if (store) pgn_game_detach(game);
     return 0;
 }
 
-static int load_pgn_games(const char *path, PGNCollection *col) {
-    FILE *f = fopen(path, "r");
-    if (!f) {
-        fprintf(stderr, "No se puede abrir archivo PGN: %s\n", path);
-        return -1;
-    }
+// Valida la partida y la carga en 'game'; los errores se escriben en 'log'
+static int validate_and_load_game(PGNGame *game, PGNView movetext, int game_number,
+                                  ErrorLog *log, Arena *arena) {
+    PGNGameError err;
+    if (check_game_moves(game, movetext, arena, 1, &err) == 0) return 0;
     
-    char line[1024];
-    PGNGame temp_game;
-    char moves_buffer[32768] = {0};
-    int in_moves = 0;
-    int game_number = 0;
-    int has_current_game = 0;
-    int valid_games = 0;
-    int invalid_games = 0;
-    
-    while (fgets(line, sizeof(line), f)) {
-        trim(line);
-        
-        if (strncmp(line, "[Event ", 7) == 0) {
-            if (has_current_game && moves_buffer[0]) {
-                game_number++;
-                
-                printf("Validando partida #%d: %s vs %s...\n", 
-                       game_number,
-                       temp_game.white[0] ? temp_game.white : "?",
-                       temp_game.black[0] ? temp_game.black : "?");
-                
-                if (validate_and_load_game(&temp_game, moves_buffer, game_number) == 0) {
-                    if (col->game_count >= col->game_capacity) {
-                        col->game_capacity *= 2;
-                        col->games = realloc(col->games, sizeof(PGNGame) * col->game_capacity);
-                    }
-                    col->games[col->game_count++] = temp_game;
-                    printf("✓ Partida #%d cargada exitosamente (%d movimientos)\n\n", 
-                           game_number, temp_game.move_count);
-                    valid_games++;
-                } else {
-                    pgn_game_free(&temp_game);
-                    printf("\n");
-                    invalid_games++;
+    int len = (int)err.move.len;
+    const char *text = err.move.ptr;
+    switch (err.kind) {
+        case PGN_ERROR_FEN:
+            error_log_printf(log, "❌ Partida #%d - FEN inválido: '%s'\n", game_number, game->fen);
+            error_log_printf(log, "   La partida no será cargada.\n");
+            break;
+        case PGN_ERROR_LEXICAL:
+            error_log_printf(log, "❌ Partida #%d - ERROR LÉXICO en movimiento %d: '%.*s'\n", 
+                    game_number, err.ply, len, text);
+            error_log_printf(log, "   La partida no será cargada.\n");
+            break;
+        case PGN_ERROR_SYNTAX:
+            error_log_printf(log, "❌ Partida #%d - ERROR SINTÁCTICO en movimiento %d: '%.*s'\n", 
+                    game_number, err.ply, len, text);
+            error_log_printf(log, "   El movimiento no cumple con la notación SAN estándar.\n");
+            break;
+        case PGN_ERROR_SEMANTIC:
+            error_log_printf(log, "❌ Partida #%d - ERROR SEMÁNTICO en movimiento %d: '%.*s'\n", 
+                    game_number, err.ply, len, text);
+            error_log_printf(log, "   Razón: %s\n", err.reason);
+            error_log_printf(log, "   La partida no será cargada.\n");
+            break;
+        default:
+            error_log_printf(log, "❌ Partida #%d: No contiene movimientos válidos\n", game_number);
+            break;
+    }
+    return -1;
+}
+
+// Inicializa la partida temporal según el modo de almacenamiento
+static void init_temp_game(PGNGame *game, const PGNOptions *opts) {
+    if (opts->compact) {
+        pgn_game_init_compact(game, opts->keyframe_interval);
+    } else {
+        pgn_game_init(game);
+    }
+}
+
+// Lee las etiquetas de la partida
+static void load_game_tags(PGNGame *game, PGNView tags) {
+    PGNView name, value;
+    while (pgn_next_tag(&tags, &name, &value)) {
+        parse_pgn_header(name, value, game);
+    }
+}
+
+int pgn_validate_game(PGNGame *game, PGNView tags, PGNView movetext, PGNGameError *err) {
+    pgn_game_init(game);
+    load_game_tags(game, tags);
+    return check_game_moves(game, movetext, NULL, 0, err);
+}
+
+static void announce_game(const PGNGame *game, int game_number) {
+    printf("Validando partida #%d: %s vs %s...\n", 
+           game_number,
+           game->white[0] ? game->white : "?",
+           game->black[0] ? game->black : "?");
+}
+
+// Contadores de la carga
+typedef struct {
+    int game_number;
+    int valid_games;
+    int invalid_games;
+} LoadStats;
+
+const char *pgn_game_expected_result(const PGNGame *game) {
+    switch (game->final_status) {
+        case POSITION_CHECKMATE: {
+            // Está mateado el bando al que le toca: el que empezó si se hizo
+            // un número par de jugadas
+            int first_is_white = (game->start_side != COLOR_BLACK);
+            int white_mated = (game->move_count % 2 == 0) == first_is_white;
+            return white_mated ? "0-1" : "1-0";
+        }
+        case POSITION_STALEMATE:
+        case POSITION_DRAW_REPETITION:
+        case POSITION_DRAW_FIFTY_MOVE:
+            return "1/2-1/2";
+        default:
+            return NULL;
+    }
+}
+
+// Tablas por regla detectadas y discrepancias con la etiqueta [Result]
+static void report_final_status(const PGNGame *game) {
+    if (game->final_status == POSITION_DRAW_REPETITION) {
+        printf("   🤝 Termina en tablas por triple repetición\n");
+    } else if (game->final_status == POSITION_DRAW_FIFTY_MOVE) {
+        printf("   🤝 Termina en tablas por la regla de 50 jugadas\n");
+    }
+
+    const char *expected = pgn_game_expected_result(game);
+    if (expected && game->result[0] && strcmp(game->result, "*") != 0 &&
+        strcmp(game->result, expected) != 0) {
+        printf("   ⚠️  [Result \"%s\"] no coincide con el final de la partida (%s)\n",
+               game->result, expected);
+    }
+}
+
+// Inserta las primeras jugadas de la partida en el árbol de aperturas
+static void add_to_opening_tree(OpeningTree *t, const PGNGame *game) {
+    if (game->fen[0]) return;   // El árbol parte de la posición inicial estándar
+
+    OpeningResult r = opening_result_from_tag(game->result);
+    int node = opening_tree_begin_game(t, r);
+    for (int i = 0; i < game->move_count && node >= 0; i++) {
+        node = opening_tree_play(t, node, pgn_game_move_code(game, i), r);
+    }
+}
+
+// Agrega una partida válida a la colección con todas sus etiquetas (y al
+// árbol de aperturas, si se construye)
+static void collection_add(PGNCollection *col, const PGNGame *game, PGNView tags) {
+    if (col->game_count >= col->game_capacity) {
+        col->game_capacity *= 2;
+        col->games = realloc(col->games, sizeof(PGNGame) * col->game_capacity);
+    }
+    col->games[col->game_count++] = *game;
+    tag_index_add_game(&col->tags, tags);
+    if (col->tree.nodes) add_to_opening_tree(&col->tree, game);
+}
+
+// Informa el resultado de una partida y, si es válida, la agrega a la colección
+static void finish_game(PGNCollection *col, PGNGame *game, PGNView tags, int game_number,
+                        int ok, LoadStats *stats) {
+    if (ok) {
+        collection_add(col, game, tags);
+        printf("✓ Partida #%d cargada exitosamente (%d movimientos)\n", 
+               game_number, game->move_count);
+        report_final_status(game);
+        printf("\n");
+        stats->valid_games++;
+    } else {
+        pgn_game_free(game);
+        printf("\n");
+        stats->invalid_games++;
+    }
+}
+
+// ============================================================================
+// VALIDACIÓN EN PARALELO
+// ============================================================================
+//
+// Un hilo lector separa las partidas (cada [Event ...]) y las deja en un
+// anillo de trabajos. Las partidas se agrupan en bloques consecutivos que se
+// reparten por turnos entre las colas de los hilos de trabajo. Cada hilo
+// toma primero los bloques más antiguos de su propia cola; cuando se queda
+// sin trabajo roba el bloque más reciente de la cola de otro hilo, así las
+// partidas largas no dejan hilos ociosos al final. El hilo principal recoge
+// los resultados en el orden original del archivo.
+
+#define PGN_CHUNK_GAMES 8    // Partidas por bloque
+
+enum { JOB_FREE, JOB_READY, JOB_DONE };
+
+typedef struct {
+    int state;
+    int game_number;
+    PGNView tags;            // Vistas al texto de la partida
+    PGNView movetext;
+    char *copy;              // Copia del texto (solo en lectura por bloques)
+    size_t copy_cap;
+    PGNGame game;
+    int ok;
+    ErrorLog log;
+} PGNJob;
+
+// Bloque de partidas consecutivas: números de secuencia [first, first + count)
+typedef struct {
+    int first;
+    int count;
+} GameChunk;
+
+// Cola de bloques de un hilo de trabajo (anillo doble)
+typedef struct {
+    pthread_mutex_t lock;
+    GameChunk *items;
+    int cap;
+    int head;                // Bloque más antiguo
+    int size;
+
+    // Estadísticas del hilo
+    long games;
+    long plies;
+    long steals;
+} WorkerQueue;
+
+typedef struct {
+    PGNReader *reader;
+    const PGNOptions *opts;
+
+    PGNJob *jobs;
+    int job_count;           // Tamaño del anillo de trabajos
+
+    WorkerQueue *queues;
+    int worker_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;  // Cambió el estado de algún trabajo
+    pthread_cond_t work;     // Hay bloques nuevos o terminó el lector
+    int produced;            // Partidas leídas
+    int pending;             // Bloques en colas aún no reservados por un hilo
+    int reader_done;
+    int read_error;
+} ParallelLoad;
+
+// Guarda la partida en el trabajo; en modo mmap las vistas ya son estables
+static int job_fill(PGNJob *job, const PGNReader *reader, const PGNRawGame *raw) {
+    if (reader->map) {
+        job->tags = raw->tags;
+        job->movetext = raw->movetext;
+        return 0;
+    }
+
+    size_t need = raw->tags.len + raw->movetext.len;
+    if (need > job->copy_cap || !job->copy) {
+        char *copy = realloc(job->copy, need + 1);
+        if (!copy) return -1;
+        job->copy = copy;
+        job->copy_cap = need;
+    }
+    if (raw->tags.len) memcpy(job->copy, raw->tags.ptr, raw->tags.len);
+    memcpy(job->copy + raw->tags.len, raw->movetext.ptr, raw->movetext.len);
+    job->tags.ptr = job->copy;
+    job->tags.len = raw->tags.len;
+    job->movetext.ptr = job->copy + raw->tags.len;
+    job->movetext.len = raw->movetext.len;
+    return 0;
+}
+
+static void queue_push(WorkerQueue *q, GameChunk c) {
+    pthread_mutex_lock(&q->lock);
+    q->items[(q->head + q->size) % q->cap] = c;
+    q->size++;
+    pthread_mutex_unlock(&q->lock);
+}
+
+// El dueño toma el bloque más antiguo (el que el recolector espera antes)
+static int queue_pop_oldest(WorkerQueue *q, GameChunk *out) {
+    int ok = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->size > 0) {
+        *out = q->items[q->head];
+        q->head = (q->head + 1) % q->cap;
+        q->size--;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+// Un ladrón toma el bloque más reciente, lejos de donde trabaja el dueño
+static int queue_steal_newest(WorkerQueue *q, GameChunk *out) {
+    int ok = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->size > 0) {
+        q->size--;
+        *out = q->items[(q->head + q->size) % q->cap];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+// Entrega un bloque completo a la cola del siguiente hilo (por turnos)
+static void publish_chunk(ParallelLoad *pl, GameChunk *c, int *next_queue) {
+    if (c->count == 0) return;
+
+    queue_push(&pl->queues[*next_queue], *c);
+    *next_queue = (*next_queue + 1) % pl->worker_count;
+
+    pthread_mutex_lock(&pl->lock);
+    pl->pending++;
+    pthread_cond_signal(&pl->work);
+    pthread_mutex_unlock(&pl->lock);
+
+    c->first += c->count;
+    c->count = 0;
+}
+
+static void *reader_thread(void *arg) {
+    ParallelLoad *pl = arg;
+    PGNRawGame raw;
+    GameChunk chunk = { 0, 0 };
+    int next_queue = 0;
+    int rc;
+
+    while ((rc = pgn_reader_next(pl->reader, &raw)) == 1) {
+        PGNJob *job = &pl->jobs[pl->produced % pl->job_count];
+
+        pthread_mutex_lock(&pl->lock);
+        if (job->state != JOB_FREE) {
+            // Antes de esperar, publicar el bloque parcial para que nadie
+            // quede esperando partidas que el lector retiene
+            pthread_mutex_unlock(&pl->lock);
+            publish_chunk(pl, &chunk, &next_queue);
+            pthread_mutex_lock(&pl->lock);
+            while (job->state != JOB_FREE) pthread_cond_wait(&pl->changed, &pl->lock);
+        }
+        pthread_mutex_unlock(&pl->lock);
+
+        if (job_fill(job, pl->reader, &raw) != 0) {
+            rc = -1;
+            break;
+        }
+
+        pthread_mutex_lock(&pl->lock);
+        job->game_number = pl->produced + 1;
+        job->state = JOB_READY;
+        pl->produced++;
+        pthread_mutex_unlock(&pl->lock);
+
+        if (++chunk.count == PGN_CHUNK_GAMES) publish_chunk(pl, &chunk, &next_queue);
+    }
+    publish_chunk(pl, &chunk, &next_queue);
+
+    pthread_mutex_lock(&pl->lock);
+    pl->reader_done = 1;
+    pl->read_error = (rc < 0);
+    pthread_cond_broadcast(&pl->work);
+    pthread_cond_broadcast(&pl->changed);
+    pthread_mutex_unlock(&pl->lock);
+    return NULL;
+}
+
+typedef struct {
+    ParallelLoad *pl;
+    int index;
+} WorkerArg;
+
+static void *worker_thread(void *arg) {
+    ParallelLoad *pl = ((WorkerArg *)arg)->pl;
+    int self = ((WorkerArg *)arg)->index;
+    WorkerQueue *own = &pl->queues[self];
+    Arena arena;
+    arena_init(&arena, PGN_ARENA_BLOCK);
+
+    while (1) {
+        // Reservar un bloque: garantiza que hay uno en alguna cola
+        pthread_mutex_lock(&pl->lock);
+        while (pl->pending == 0 && !pl->reader_done) {
+            pthread_cond_wait(&pl->work, &pl->lock);
+        }
+        if (pl->pending == 0) {   // lector terminado y sin bloques
+            pthread_mutex_unlock(&pl->lock);
+            arena_free(&arena);
+            status_cache_flush_thread_stats();
+            return NULL;
+        }
+        pl->pending--;
+        pthread_mutex_unlock(&pl->lock);
+
+        // Primero la cola propia; si está vacía, robar a los demás. El bloque
+        // reservado ya está en alguna cola, pero otro hilo puede tomarlo
+        // mientras se recorren: tras una vuelta sin éxito se cede la CPU
+        // en lugar de girar
+        GameChunk chunk;
+        int found = queue_pop_oldest(own, &chunk);
+        while (!found) {
+            for (int k = 1; k < pl->worker_count && !found; k++) {
+                WorkerQueue *victim = &pl->queues[(self + k) % pl->worker_count];
+                if (queue_steal_newest(victim, &chunk)) {
+                    own->steals++;
+                    found = 1;
                 }
             }
-            
-            pgn_game_init(&temp_game);
-            moves_buffer[0] = '\0';
-            in_moves = 0;
-            has_current_game = 1;
+            if (!found) found = queue_pop_oldest(own, &chunk);
+            if (!found) sched_yield();
         }
-        
-        if (line[0] == '[' && has_current_game) {
-            parse_pgn_header(line, &temp_game);
-            in_moves = 0;
+
+        for (int seq = chunk.first; seq < chunk.first + chunk.count; seq++) {
+            PGNJob *job = &pl->jobs[seq % pl->job_count];
+
+            init_temp_game(&job->game, pl->opts);
+            load_game_tags(&job->game, job->tags);
+            job->log.len = 0;
+            job->ok = (validate_and_load_game(&job->game, job->movetext,
+                                              job->game_number, &job->log, &arena) == 0);
+            own->games++;
+            own->plies += job->game.move_count;
+
+            pthread_mutex_lock(&pl->lock);
+            job->state = JOB_DONE;
+            pthread_cond_broadcast(&pl->changed);
+            pthread_mutex_unlock(&pl->lock);
         }
-        else if (line[0] == '\0' && has_current_game) {
-            in_moves = 1;
+    }
+}
+
+// Valida las partidas con opts->jobs hilos. Devuelve -1 si hubo error de lectura
+static int load_parallel(PGNReader *reader, PGNCollection *col,
+                         const PGNOptions *opts, LoadStats *stats) {
+    ParallelLoad pl;
+    memset(&pl, 0, sizeof(pl));
+    pl.reader = reader;
+    pl.opts = opts;
+    pl.worker_count = opts->jobs;
+    pl.job_count = opts->jobs * PGN_CHUNK_GAMES * 4;
+    pl.jobs = calloc((size_t)pl.job_count, sizeof(PGNJob));
+    pl.queues = calloc((size_t)pl.worker_count, sizeof(WorkerQueue));
+    pthread_t *threads = malloc(sizeof(pthread_t) * (size_t)pl.worker_count);
+    WorkerArg *args = malloc(sizeof(WorkerArg) * (size_t)pl.worker_count);
+    if (!pl.jobs || !pl.queues || !threads || !args) {
+        free(pl.jobs);
+        free(pl.queues);
+        free(threads);
+        free(args);
+        return -1;
+    }
+
+    for (int i = 0; i < pl.worker_count; i++) {
+        WorkerQueue *q = &pl.queues[i];
+        pthread_mutex_init(&q->lock, NULL);
+        q->cap = pl.job_count;   // nunca hay más bloques que partidas en el anillo
+        q->items = malloc(sizeof(GameChunk) * (size_t)q->cap);
+    }
+    pthread_mutex_init(&pl.lock, NULL);
+    pthread_cond_init(&pl.changed, NULL);
+    pthread_cond_init(&pl.work, NULL);
+
+    pthread_t reader_tid;
+    int started = 0;
+    for (int i = 0; i < pl.worker_count; i++) {
+        args[i].pl = &pl;
+        args[i].index = i;
+        if (pthread_create(&threads[i], NULL, worker_thread, &args[i]) == 0) started++;
+        else break;
+    }
+    pl.worker_count = started;   // los bloques solo van a hilos en marcha
+    if (started == 0 || pthread_create(&reader_tid, NULL, reader_thread, &pl) != 0) {
+        fprintf(stderr, "No se pudieron crear los hilos de validación\n");
+        pthread_mutex_lock(&pl.lock);
+        pl.reader_done = 1;
+        pthread_cond_broadcast(&pl.work);
+        pthread_mutex_unlock(&pl.lock);
+        for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+        started = -1;
+    }
+
+    // Recoger los resultados en orden
+    for (int seq = 0; started > 0; seq++) {
+        PGNJob *job = &pl.jobs[seq % pl.job_count];
+
+        pthread_mutex_lock(&pl.lock);
+        while (!(seq < pl.produced && job->state == JOB_DONE) &&
+               !(pl.reader_done && seq >= pl.produced)) {
+            pthread_cond_wait(&pl.changed, &pl.lock);
         }
-        else if (in_moves && line[0] != '\0' && has_current_game) {
-            strcat(moves_buffer, " ");
-            strcat(moves_buffer, line);
+        int finished = (seq >= pl.produced);
+        pthread_mutex_unlock(&pl.lock);
+        if (finished) break;
+
+        stats->game_number++;
+        announce_game(&job->game, job->game_number);
+        if (job->log.len) fwrite(job->log.data, 1, job->log.len, stderr);
+        finish_game(col, &job->game, job->tags, job->game_number, job->ok, stats);
+
+        pthread_mutex_lock(&pl.lock);
+        job->state = JOB_FREE;
+        pthread_cond_broadcast(&pl.changed);
+        pthread_mutex_unlock(&pl.lock);
+    }
+
+    if (started > 0) {
+        pthread_join(reader_tid, NULL);
+        for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+
+        printf("Estadísticas por hilo:\n");
+        for (int i = 0; i < started; i++) {
+            printf("  🧵 Hilo %d: %ld partidas, %ld jugadas, %ld robos\n",
+                   i + 1, pl.queues[i].games, pl.queues[i].plies, pl.queues[i].steals);
         }
     }
-    
-    if (has_current_game && moves_buffer[0]) {
-        game_number++;
-        
-        printf("Validando partida #%d: %s vs %s...\n", 
-               game_number,
-               temp_game.white[0] ? temp_game.white : "?",
-               temp_game.black[0] ? temp_game.black : "?");
-        
-        if (validate_and_load_game(&temp_game, moves_buffer, game_number) == 0) {
-            if (col->game_count >= col->game_capacity) {
-                col->game_capacity *= 2;
-                col->games = realloc(col->games, sizeof(PGNGame) * col->game_capacity);
+
+    for (int i = 0; i < pl.job_count; i++) {
+        free(pl.jobs[i].copy);
+        free(pl.jobs[i].log.data);
+    }
+    for (int i = 0; i < opts->jobs; i++) {
+        free(pl.queues[i].items);
+        pthread_mutex_destroy(&pl.queues[i].lock);
+    }
+    free(pl.jobs);
+    free(pl.queues);
+    free(threads);
+    free(args);
+    pthread_mutex_destroy(&pl.lock);
+    pthread_cond_destroy(&pl.changed);
+    pthread_cond_destroy(&pl.work);
+    return (started < 0 || pl.read_error) ? -1 : 0;
+}
+
+// ============================================================================
+// CACHÉ BINARIA DE PARTIDAS
+// ============================================================================
+
+// Reconstruye una partida guardada en la caché: las jugadas se aplican con
+// board_make_move a partir de sus códigos, sin volver a validarlas.
+// 0 = éxito, -1 = registro inconsistente
+static int game_from_cache(PGNGame *game, const GameCacheRecord *rec, Arena *arena) {
+    snprintf(game->event, sizeof(game->event), "%s", rec->event);
+    snprintf(game->white, sizeof(game->white), "%s", rec->white);
+    snprintf(game->black, sizeof(game->black), "%s", rec->black);
+    snprintf(game->result, sizeof(game->result), "%s", rec->result);
+    snprintf(game->fen, sizeof(game->fen), "%s", rec->fen);
+    game->final_status = rec->final_status;
+    game->start_side = (rec->start_side == COLOR_BLACK) ? COLOR_BLACK : COLOR_WHITE;
+
+    Board board;
+    pgn_game_start_board(game, &board);
+    Color side = game->start_side;
+
+    arena_reset(arena);
+    const char *text = rec->texts;
+    const char *texts_end = rec->texts ? rec->texts + rec->texts_len : NULL;
+
+    for (int i = 0; i < rec->move_count; i++) {
+        Move code;
+        memcpy(&code, rec->codes + 2 * (size_t)i, sizeof(code));
+        unsigned char piece = board.squares[MOVE_FROM(code)];
+        if (!piece || (Color)(piece >> 3) != side) {
+            pgn_game_drop_moves(game);
+            return -1;
+        }
+
+        MoveUndo undo;
+        board_make_move(&board, code, &undo);
+
+        MoveAST ast;
+        size_t len = 0;
+        memset(&ast, 0, sizeof(ast));
+        if (text) {
+            const char *nul = (text < texts_end) ? memchr(text, '\0', (size_t)(texts_end - text)) : NULL;
+            if (!nul) {
+                pgn_game_drop_moves(game);
+                return -1;
             }
-            col->games[col->game_count++] = temp_game;
-            printf("✓ Partida #%d cargada exitosamente (%d movimientos)\n\n", 
-                   game_number, temp_game.move_count);
-            valid_games++;
+            len = (size_t)(nul - text);
+            san_parse(text, len, &ast);
+        }
+
+        pgn_game_add_move(game, arena, text ? text : "", len, &ast, &board, side, code);
+        if (text) text += len + 1;
+        side = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    }
+
+    pgn_game_detach(game);
+    return 0;
+}
+
+// Carga las partidas desde <path>.cgc si corresponde al archivo.
+// 1 = cargadas; 0 = sin caché válida (la colección queda vacía)
+static int load_from_cache(const char *path, const GameCacheKey *key, PGNCollection *col,
+                           const PGNOptions *opts, LoadStats *stats) {
+    GameCacheReader reader;
+    if (!game_cache_open(&reader, path, key)) return 0;
+
+    GameCacheRecord rec;
+    PGNGame game;
+    Arena arena;
+    arena_init(&arena, PGN_ARENA_BLOCK);
+
+    int rc;
+    while ((rc = game_cache_next(&reader, &rec)) == 1) {
+        // En modo normal se necesitan los textos originales de las jugadas
+        if (!opts->compact && !rec.texts) {
+            rc = -1;
+            break;
+        }
+        init_temp_game(&game, opts);
+        if (game_from_cache(&game, &rec, &arena) != 0) {
+            rc = -1;
+            break;
+        }
+        PGNView tags = { rec.tags, strlen(rec.tags) };
+        collection_add(col, &game, tags);
+    }
+    arena_free(&arena);
+
+    if (rc == 0 && col->game_count == reader.games) {
+        stats->game_number = reader.processed;
+        stats->valid_games = col->game_count;
+        stats->invalid_games = reader.processed - col->game_count;
+        game_cache_close(&reader);
+        return 1;
+    }
+
+    // Caché dañada o incompleta: se descarta lo cargado
+    game_cache_close(&reader);
+    for (int i = 0; i < col->game_count; i++) pgn_game_free(&col->games[i]);
+    col->game_count = 0;
+    tag_index_free(&col->tags);
+    tag_index_init(&col->tags);
+    if (col->tree.nodes) {
+        int depth = col->tree.max_depth;
+        opening_tree_free(&col->tree);
+        opening_tree_init(&col->tree, depth);
+    }
+    return 0;
+}
+
+// Guarda la colección en <path>.cgc. 0 = éxito
+static int save_to_cache(const char *path, const GameCacheKey *key, const PGNCollection *col,
+                         const LoadStats *stats) {
+    GameCacheWriter w;
+    if (game_cache_create(&w, path, key) != 0) return -1;
+
+    Move *codes = NULL;
+    char *texts = NULL, *tags = NULL;
+    size_t codes_cap = 0, texts_cap = 0, tags_cap = 0;
+    int rc = 0;
+
+    for (int i = 0; i < col->game_count && rc == 0; i++) {
+        const PGNGame *g = &col->games[i];
+
+        // Las etiquetas se vuelven a escribir como líneas [Nombre "Valor"]
+        size_t tags_len = tag_index_format(&col->tags, i, tags, tags_cap);
+        if (tags_len >= tags_cap) {
+            tags_cap = (tags_len + 1) * 2;
+            tags = realloc(tags, tags_cap);
+            if (!tags) { perror("realloc"); exit(EXIT_FAILURE); }
+            tag_index_format(&col->tags, i, tags, tags_cap);
+        }
+
+        GameCacheRecord rec = {
+            g->event, g->white, g->black, g->result, g->fen, tags,
+            g->final_status, g->start_side, g->move_count, NULL, NULL, 0
+        };
+
+        if (g->keyframe_interval > 0) {
+            rec.codes = (const unsigned char *)g->codes;
         } else {
-            pgn_game_free(&temp_game);
-            printf("\n");
-            invalid_games++;
+            // Modo normal: códigos y textos SAN de cada jugada
+            if ((size_t)g->move_count > codes_cap) {
+                codes_cap = (size_t)g->move_count;
+                codes = realloc(codes, sizeof(Move) * codes_cap);
+            }
+            size_t len = 0;
+            for (int m = 0; m < g->move_count; m++) {
+                const char *t = g->moves[m].move_text;
+                size_t n = strlen(t) + 1;
+                if (len + n > texts_cap) {
+                    texts_cap = (len + n) * 2;
+                    texts = realloc(texts, texts_cap);
+                }
+                if (!codes || !texts) { perror("realloc"); exit(EXIT_FAILURE); }
+                memcpy(texts + len, t, n);
+                len += n;
+                codes[m] = g->moves[m].code;
+            }
+            rec.codes = (const unsigned char *)codes;
+            rec.texts = texts ? texts : "";
+            rec.texts_len = len;
+        }
+        rc = game_cache_write(&w, &rec);
+    }
+
+    free(codes);
+    free(texts);
+    free(tags);
+    if (rc != 0) {
+        game_cache_abort(&w);
+        return -1;
+    }
+    return game_cache_commit(&w, stats->game_number);
+}
+
+// ============================================================================
+// CARGA DE PARTIDAS
+// ============================================================================
+
+// Lee y valida todas las partidas del archivo.
+// 0 = éxito, -1 = error de lectura, -2 = no se puede abrir
+static int load_from_pgn(const char *path, PGNCollection *col, const PGNOptions *opts,
+                         LoadStats *stats) {
+    PGNReader reader;
+    int rc = opts->use_mmap ? pgn_reader_open_mmap(&reader, path)
+                            : pgn_reader_open(&reader, path);
+    if (rc != 0) return -2;
+    
+    if (opts->jobs > 1) {
+        // Tablas de ataque y claves Zobrist listas antes de que arranquen los hilos
+        attacks_init();
+        zobrist_init();
+        rc = load_parallel(&reader, col, opts, stats);
+    } else {
+        PGNRawGame raw;
+        PGNGame temp_game;
+        Arena arena;
+        arena_init(&arena, PGN_ARENA_BLOCK);
+        
+        // Las partidas se leen y validan de una en una
+        while ((rc = pgn_reader_next(&reader, &raw)) == 1) {
+            stats->game_number++;
+            
+            init_temp_game(&temp_game, opts);
+            load_game_tags(&temp_game, raw.tags);
+            announce_game(&temp_game, stats->game_number);
+            
+            int ok = (validate_and_load_game(&temp_game, raw.movetext,
+                                             stats->game_number, NULL, &arena) == 0);
+            finish_game(col, &temp_game, raw.tags, stats->game_number, ok, stats);
         }
+        arena_free(&arena);
     }
     
-    fclose(f);
+    pgn_reader_close(&reader);
+    return (rc < 0) ? -1 : 0;
+}
+
+static int load_pgn_games(const char *path, PGNCollection *col, const PGNOptions *opts) {
+    LoadStats stats = { 0, 0, 0 };
+    if (opts->opening_tree) opening_tree_init(&col->tree, opts->tree_depth);
+    
+    // Si el archivo no cambió desde la última carga, las partidas salen de
+    // la caché <path>.cgc sin volver a validarlas
+    GameCacheKey key;
+    int use_cache = !opts->no_game_cache && game_cache_key(path, &key) == 0;
+    const char *cache_note = NULL;
+    
+    if (use_cache && load_from_cache(path, &key, col, opts, &stats)) {
+        cache_note = "leída de";
+    } else {
+        int rc = load_from_pgn(path, col, opts, &stats);
+        if (rc == -2) {
+            fprintf(stderr, "No se puede abrir archivo PGN: %s\n", path);
+            return -1;
+        }
+        if (rc < 0) {
+            fprintf(stderr, "Error de lectura en archivo PGN: %s\n", path);
+        } else if (use_cache && save_to_cache(path, &key, col, &stats) == 0) {
+            cache_note = "guardada en";
+        }
+    }
     
     printf("════════════════════════════════════════════════════════════\n");
     printf("Resumen de carga:\n");
-    printf("  ✓ Partidas válidas:   %d\n", valid_games);
-    printf("  ❌ Partidas inválidas: %d\n", invalid_games);
-    printf("  📊 Total procesadas:  %d\n", game_number);
+    printf("  ✓ Partidas válidas:   %d\n", stats.valid_games);
+    printf("  ❌ Partidas inválidas: %d\n", stats.invalid_games);
+    printf("  📊 Total procesadas:  %d\n", stats.game_number);
+    StatusCacheStats cache = status_cache_stats();
+    if (cache.probes > 0) {
+        printf("  🗃️  Caché de estados:  %.1f%% aciertos (%llu consultas)\n",
+               100.0 * (double)cache.hits / (double)cache.probes,
+               (unsigned long long)cache.probes);
+    }
+    if (opts->compact) {
+        // Memoria de jugadas en modo compacto: códigos + tableros clave
+        size_t bytes = 0;
+        long plies = 0;
+        for (int i = 0; i < col->game_count; i++) {
+            const PGNGame *g = &col->games[i];
+            bytes += sizeof(Move) * g->move_capacity;
+            bytes += sizeof(Board) * (g->move_count / g->keyframe_interval);
+            plies += g->move_count;
+        }
+        printf("  📦 Memoria de jugadas: %zu bytes (%.2f bytes/jugada)\n",
+               bytes, plies ? (double)bytes / plies : 0.0);
+    }
+    if (col->tree.nodes) {
+        printf("  🌳 Árbol de aperturas: %d nodos para %ld jugadas\n",
+               col->tree.count, col->tree.plies);
+    }
+    if (cache_note) {
+        printf("  💾 Caché de partidas: %s %s.cgc\n", cache_note, path);
+    }
     printf("════════════════════════════════════════════════════════════\n\n");
     
     return 0;
 }
 
+// ============================================================================
+// CARGA DIFERIDA
+// ============================================================================
+//
+// Con --lazy el archivo se recorre una sola vez para armar un índice: las
+// etiquetas de cada partida y la vista de su texto de jugadas sobre la
+// proyección del archivo. El menú se muestra enseguida; cada partida se
+// valida cuando se elige o antes, en hilos de fondo que recorren el índice
+// en orden. Los mensajes de error se guardan y se muestran al elegirla.
+
+enum { LAZY_PENDING, LAZY_RUNNING, LAZY_VALID, LAZY_INVALID };
+
+typedef struct {
+    PGNView movetext;        // Vista sobre la proyección (o sobre 'copy')
+    char *copy;              // Copia del texto (solo en lectura por bloques)
+    ErrorLog log;            // Mensajes de error si la partida es inválida
+    int state;
+} LazyEntry;
+
+typedef struct {
+    PGNReader reader;        // Abierto mientras dure el menú: las vistas apuntan a él
+    PGNCollection *col;      // col->games[i] = partida i del archivo
+    LazyEntry *entries;
+    int entry_capacity;
+    const PGNOptions *opts;
+
+    pthread_mutex_t lock;    // Protege 'state', 'next', los contadores y col->games
+    pthread_cond_t changed;  // Terminó la validación de alguna partida
+    int next;                // Siguiente partida para los hilos de fondo
+    int validated;           // Partidas ya validadas (válidas o no)
+    int stop;                // 1 = los hilos de fondo deben terminar
+
+    pthread_t *threads;
+    int thread_count;
+    Arena arena;             // Arena del hilo principal
+} LazyIndex;
+
+// Agrega la partida al índice con sus etiquetas; la validación queda pendiente
+static int lazy_index_add(LazyIndex *lz, const PGNRawGame *raw) {
+    PGNCollection *col = lz->col;
+    if (col->game_count >= lz->entry_capacity) {
+        int cap = lz->entry_capacity ? lz->entry_capacity * 2 : 1024;
+        LazyEntry *entries = realloc(lz->entries, sizeof(LazyEntry) * (size_t)cap);
+        if (!entries) return -1;
+        lz->entries = entries;
+        lz->entry_capacity = cap;
+    }
+
+    LazyEntry *e = &lz->entries[col->game_count];
+    memset(e, 0, sizeof(*e));
+    e->movetext = raw->movetext;
+    if (!lz->reader.map) {
+        e->copy = malloc(raw->movetext.len + 1);
+        if (!e->copy) return -1;
+        memcpy(e->copy, raw->movetext.ptr, raw->movetext.len);
+        e->movetext.ptr = e->copy;
+    }
+    e->state = LAZY_PENDING;
+
+    PGNGame game;
+    init_temp_game(&game, lz->opts);
+    load_game_tags(&game, raw->tags);
+    collection_add(col, &game, raw->tags);
+    return 0;
+}
+
+// Valida la partida 'idx' (ya marcada LAZY_RUNNING por quien la llama) y
+// publica el resultado
+static void lazy_validate(LazyIndex *lz, int idx, Arena *arena) {
+    LazyEntry *e = &lz->entries[idx];
+
+    // Las etiquetas no cambian después de indexar: se puede leer sin el candado
+    PGNGame game = lz->col->games[idx];
+    int ok = (validate_and_load_game(&game, e->movetext, idx + 1, &e->log, arena) == 0);
+
+    pthread_mutex_lock(&lz->lock);
+    if (ok) lz->col->games[idx] = game;
+    e->state = ok ? LAZY_VALID : LAZY_INVALID;
+    lz->validated++;
+    pthread_cond_broadcast(&lz->changed);
+    pthread_mutex_unlock(&lz->lock);
+}
+
+static void *lazy_thread(void *arg) {
+    LazyIndex *lz = arg;
+    Arena arena;
+    arena_init(&arena, PGN_ARENA_BLOCK);
+
+    while (1) {
+        // Reservar la siguiente partida pendiente (las elegidas en el menú
+        // pueden estar ya validadas)
+        pthread_mutex_lock(&lz->lock);
+        while (!lz->stop && lz->next < lz->col->game_count &&
+               lz->entries[lz->next].state != LAZY_PENDING) {
+            lz->next++;
+        }
+        if (lz->stop || lz->next >= lz->col->game_count) {
+            pthread_mutex_unlock(&lz->lock);
+            break;
+        }
+        int idx = lz->next++;
+        lz->entries[idx].state = LAZY_RUNNING;
+        pthread_mutex_unlock(&lz->lock);
+
+        lazy_validate(lz, idx, &arena);
+    }
+
+    arena_free(&arena);
+    status_cache_flush_thread_stats();
+    return NULL;
+}
+
+// Valida la partida 'idx' si todavía no lo está (si la tiene un hilo de
+// fondo, espera a que termine). 1 = válida, 0 = inválida
+static int lazy_ensure(LazyIndex *lz, int idx) {
+    LazyEntry *e = &lz->entries[idx];
+
+    pthread_mutex_lock(&lz->lock);
+    while (e->state == LAZY_RUNNING) {
+        pthread_cond_wait(&lz->changed, &lz->lock);
+    }
+    int mine = (e->state == LAZY_PENDING);
+    if (mine) e->state = LAZY_RUNNING;
+    pthread_mutex_unlock(&lz->lock);
+
+    if (mine) lazy_validate(lz, idx, &lz->arena);
+    return e->state == LAZY_VALID;
+}
+
+// Indexa el archivo y arranca la validación de fondo con opts->jobs hilos.
+// 0 = éxito, -1 = error de lectura, -2 = no se puede abrir
+static int lazy_index_open(LazyIndex *lz, const char *path, PGNCollection *col,
+                           const PGNOptions *opts) {
+    memset(lz, 0, sizeof(*lz));
+    lz->col = col;
+    lz->opts = opts;
+    if (pgn_reader_open_mmap(&lz->reader, path) != 0) return -2;
+
+    PGNRawGame raw;
+    int rc;
+    while ((rc = pgn_reader_next(&lz->reader, &raw)) == 1) {
+        if (lazy_index_add(lz, &raw) != 0) {
+            rc = -1;
+            break;
+        }
+    }
+
+    pthread_mutex_init(&lz->lock, NULL);
+    pthread_cond_init(&lz->changed, NULL);
+    arena_init(&lz->arena, PGN_ARENA_BLOCK);
+
+    // Tablas de ataque y claves Zobrist listas antes de que arranquen los hilos
+    attacks_init();
+    zobrist_init();
+    int count = opts->jobs > 1 ? opts->jobs : 1;
+    lz->threads = malloc(sizeof(pthread_t) * (size_t)count);
+    for (int i = 0; lz->threads && i < count && col->game_count > 0; i++) {
+        if (pthread_create(&lz->threads[i], NULL, lazy_thread, lz) != 0) break;
+        lz->thread_count++;
+    }
+    return (rc < 0) ? -1 : 0;
+}
+
+// Detiene los hilos de fondo y libera el índice (no la colección)
+static void lazy_index_close(LazyIndex *lz) {
+    pthread_mutex_lock(&lz->lock);
+    lz->stop = 1;
+    pthread_mutex_unlock(&lz->lock);
+    for (int i = 0; i < lz->thread_count; i++) pthread_join(lz->threads[i], NULL);
+    free(lz->threads);
+
+    // Las partidas que no llegaron a validarse solo tienen etiquetas
+    for (int i = 0; i < lz->col->game_count; i++) {
+        free(lz->entries[i].copy);
+        free(lz->entries[i].log.data);
+    }
+    free(lz->entries);
+    arena_free(&lz->arena);
+    pthread_mutex_destroy(&lz->lock);
+    pthread_cond_destroy(&lz->changed);
+    pgn_reader_close(&lz->reader);
+}
+
 // ============================================================================
 // MODO REPLAY
 // ============================================================================
@@ -344,6 +1346,16 @@ static void display_game_header(const PGNGame *game) {
     printf("╚════════════════════════════════════════════════════════════╝\n");
 }
 
+// Imprime "Movimiento i/n: SAN (Color)" para la jugada 'idx'
+static void print_move_line(const PGNGame *game, int idx) {
+    char text[64];
+    pgn_game_move_text(game, idx, text, sizeof(text));
+    printf("\nMovimiento %d/%d: %s (%s)\n", 
+           idx + 1, game->move_count,
+           text,
+           pgn_game_move_side(game, idx) == COLOR_WHITE ? "Blancas" : "Negras");
+}
+
 static void replay_game(PGNGame *game) {
     int current_move = -1;
     Board display_board;
@@ -356,7 +1368,7 @@ static void replay_game(PGNGame *game) {
     printf("  'j <num>' = Saltar a movimiento <num>\n");
     printf("  'q' = Salir del replay\n\n");
     
-    board_init_start(&display_board);
+    pgn_game_board_at(game, 0, &display_board);
     board_print(&display_board);
     printf("\nPosición inicial (0/%d movimientos)\n", game->move_count);
     
@@ -371,13 +1383,10 @@ static void replay_game(PGNGame *game) {
         if (input[0] == '\0' || strcmp(input, "n") == 0) {
             if (current_move + 1 < game->move_count) {
                 current_move++;
-                display_board = game->moves[current_move].board_state;
+                pgn_game_board_at(game, current_move + 1, &display_board);
                 printf("\n");
                 board_print(&display_board);
-                printf("\nMovimiento %d/%d: %s (%s)\n", 
-                       current_move + 1, game->move_count,
-                       game->moves[current_move].move_text,
-                       game->moves[current_move].side_to_move == COLOR_WHITE ? "Blancas" : "Negras");
+                print_move_line(game, current_move);
             } else {
                 printf("Ya estás en el último movimiento\n");
             }
@@ -385,18 +1394,11 @@ static void replay_game(PGNGame *game) {
         else if (strcmp(input, "b") == 0) {
             if (current_move >= 0) {
                 current_move--;
-                if (current_move >= 0) {
-                    display_board = game->moves[current_move].board_state;
-                } else {
-                    board_init_start(&display_board);
-                }
+                pgn_game_board_at(game, current_move + 1, &display_board);
                 printf("\n");
                 board_print(&display_board);
                 if (current_move >= 0) {
-                    printf("\nMovimiento %d/%d: %s (%s)\n", 
-                           current_move + 1, game->move_count,
-                           game->moves[current_move].move_text,
-                           game->moves[current_move].side_to_move == COLOR_WHITE ? "Blancas" : "Negras");
+                    print_move_line(game, current_move);
                 } else {
                     printf("\nPosición inicial (0/%d movimientos)\n", game->move_count);
                 }
@@ -408,19 +1410,16 @@ static void replay_game(PGNGame *game) {
             int target = atoi(input + 2);
             if (target < 0) {
                 current_move = -1;
-                board_init_start(&display_board);
+                pgn_game_board_at(game, 0, &display_board);
                 printf("\n");
                 board_print(&display_board);
                 printf("\nPosición inicial (0/%d movimientos)\n", game->move_count);
             } else if (target > 0 && target <= game->move_count) {
                 current_move = target - 1;
-                display_board = game->moves[current_move].board_state;
+                pgn_game_board_at(game, current_move + 1, &display_board);
                 printf("\n");
                 board_print(&display_board);
-                printf("\nMovimiento %d/%d: %s (%s)\n", 
-                       current_move + 1, game->move_count,
-                       game->moves[current_move].move_text,
-                       game->moves[current_move].side_to_move == COLOR_WHITE ? "Blancas" : "Negras");
+                print_move_line(game, current_move);
             } else {
                 printf("Movimiento fuera de rango (1-%d)\n", game->move_count);
             }
@@ -434,55 +1433,289 @@ static void replay_game(PGNGame *game) {
     }
 }
 
+// ============================================================================
+// EXPLORADOR DEL ÁRBOL DE APERTURAS
+// ============================================================================
+
+// Posición del nodo: las jugadas del camino aplicadas desde la inicial
+static void opening_node_board(const OpeningTree *t, int node, Board *out) {
+    if (node <= OPENING_TREE_ROOT) {
+        board_init_start(out);
+        return;
+    }
+    opening_node_board(t, t->nodes[node].parent, out);
+    MoveUndo undo;
+    board_make_move(out, t->nodes[node].move, &undo);
+}
+
+static double percent(int part, int total) {
+    return total ? 100.0 * part / total : 0.0;
+}
+
+// Imprime la posición del nodo y las jugadas que se hicieron en ella;
+// 'children' recibe los hijos en el orden listado
+static int print_opening_node(const OpeningTree *t, int node, Board *b,
+                              int *children, int max) {
+    const OpeningNode *n = &t->nodes[node];
+    printf("\n");
+    board_print(b);
+    printf("\nPosición tras %d jugada(s): %d partida(s) "
+           "(1-0: %.1f%%, ½-½: %.1f%%, 0-1: %.1f%%)\n",
+           n->depth, n->games,
+           percent(n->white_wins, n->games), percent(n->draws, n->games),
+           percent(n->black_wins, n->games));
+
+    int count = opening_tree_children(t, node, children, max);
+    if (count == 0) {
+        printf("No hay más jugadas registradas en esta posición\n");
+        return 0;
+    }
+
+    printf("Jugadas (%s):\n", n->depth % 2 == 0 ? "Blancas" : "Negras");
+    for (int i = 0; i < count; i++) {
+        const OpeningNode *c = &t->nodes[children[i]];
+        char san[16];
+        board_move_to_san(b, c->move, san, sizeof(san));
+        printf("  [%d] %-8s %6d partida(s)  1-0: %5.1f%%  ½-½: %5.1f%%  0-1: %5.1f%%\n",
+               i + 1, san, c->games,
+               percent(c->white_wins, c->games), percent(c->draws, c->games),
+               percent(c->black_wins, c->games));
+    }
+    return count;
+}
+
+static void explore_opening_tree(const OpeningTree *t) {
+    int node = OPENING_TREE_ROOT;
+    int children[256];
+    Board board;
+
+    printf("\nComandos:\n");
+    printf("  <num> o jugada SAN = Avanzar por esa jugada\n");
+    printf("  'b' = Volver a la posición anterior\n");
+    printf("  'q' = Salir del árbol\n");
+
+    opening_node_board(t, node, &board);
+    int count = print_opening_node(t, node, &board, children, 256);
+
+    char input[256];
+    while (1) {
+        printf("\narbol> ");
+        if (!fgets(input, sizeof(input), stdin)) break;
+
+        input[strcspn(input, "\r\n")] = '\0';
+        trim(input);
+
+        if (strcmp(input, "q") == 0) break;
+
+        int next = -1;
+        if (input[0] == '\0') {
+            next = node;
+        } else if (strcmp(input, "b") == 0) {
+            if (node == OPENING_TREE_ROOT) {
+                printf("Ya estás en la posición inicial\n");
+                continue;
+            }
+            next = t->nodes[node].parent;
+        } else if (isdigit((unsigned char)input[0])) {
+            int k = atoi(input);
+            if (k < 1 || k > count) {
+                printf("Jugada fuera de rango (1-%d)\n", count);
+                continue;
+            }
+            next = children[k - 1];
+        } else {
+            // Jugada en SAN: se valida sobre una copia de la posición
+            MoveAST ast;
+            Board after = board;
+            Move code = 0;
+            char err[256] = {0};
+            Color side = (t->nodes[node].depth % 2 == 0) ? COLOR_WHITE : COLOR_BLACK;
+            if (san_parse(input, strlen(input), &ast) != 0) {
+                printf("Jugada no reconocida: %s\n", input);
+                continue;
+            }
+            if (board_apply_move_ex(&after, &ast, side, &code, err, sizeof(err)) != 0) {
+                printf("%s\n", err);
+                continue;
+            }
+            next = opening_tree_child(t, node, code);
+            if (next < 0) {
+                printf("Ninguna partida de la colección jugó %s en esta posición\n", input);
+                continue;
+            }
+        }
+
+        node = next;
+        opening_node_board(t, node, &board);
+        count = print_opening_node(t, node, &board, children, 256);
+    }
+}
+
+// ============================================================================
+// BÚSQUEDA POR ETIQUETAS
+// ============================================================================
+
+// Línea de la partida 'i' en el menú; 'state' indica si ya se validó (LAZY_*)
+static void print_game_entry(const PGNCollection *col, int i, int state) {
+    const PGNGame *g = &col->games[i];
+
+    // Las partidas aún sin validar no tienen cantidad de movimientos
+    char moves[32];
+    if (state == LAZY_VALID) {
+        snprintf(moves, sizeof(moves), "%d movimientos", g->move_count);
+    } else {
+        snprintf(moves, sizeof(moves), "%s", state == LAZY_INVALID ? "inválida" : "sin validar");
+    }
+    printf("[%d] %s: %s vs %s (%s) - %s\n", 
+           i + 1,
+           g->event[0] ? g->event : "Sin título",
+           g->white[0] ? g->white : "?",
+           g->black[0] ? g->black : "?",
+           moves,
+           g->result[0] ? g->result : "*");
+}
+
+// Lista las partidas que cumplen la consulta (ver tag_query_parse), usando
+// solo el índice de etiquetas
+static void search_games(PGNCollection *col, char *query, LazyIndex *lazy) {
+    TagQuery q;
+    char err[128];
+    if (tag_query_parse(&q, query, err, sizeof(err)) != 0) {
+        printf("Consulta inválida: %s\n", err);
+        printf("Ejemplo: f eco=D35 whiteelo>2700 date>=2020 player=\"Carlsen, Magnus\"\n");
+        return;
+    }
+
+    int *found = malloc(sizeof(int) * ((size_t)col->game_count + 1));
+    if (!found) return;
+    int count = tag_index_query(&col->tags, &q, found);
+
+    printf("\n════════════════════════════════════════════════════════════\n");
+    printf("PARTIDAS ENCONTRADAS: %d\n", count);
+    printf("════════════════════════════════════════════════════════════\n");
+    if (lazy) pthread_mutex_lock(&lazy->lock);
+    for (int k = 0; k < count; k++) {
+        print_game_entry(col, found[k], lazy ? lazy->entries[found[k]].state : LAZY_VALID);
+    }
+    if (lazy) pthread_mutex_unlock(&lazy->lock);
+    printf("════════════════════════════════════════════════════════════\n");
+    free(found);
+}
+
 // ============================================================================
 // FUNCIÓN PRINCIPAL DEL MODO PGN
 // ============================================================================
 
 int pgn_mode(const char *path) {
+    return pgn_mode_ex(path, NULL);
+}
+
+int pgn_mode_ex(const char *path, const PGNOptions *opts) {
+    PGNOptions o = { .jobs = 1 };
+    if (opts) o = *opts;
+    if (o.keyframe_interval <= 0) o.keyframe_interval = PGN_KEYFRAME_INTERVAL;
+
     PGNCollection col;
     pgn_collection_init(&col);
     
     printf("Cargando partidas desde: %s\n", path);
-    
-    if (load_pgn_games(path, &col) != 0) {
-        pgn_collection_free(&col);
-        return -1;
+    if (o.jobs > 1) {
+        printf("Validación en paralelo: %d hilos\n", o.jobs);
+    }
+    if (o.compact) {
+        printf("Almacenamiento compacto: tablero clave cada %d jugadas\n", o.keyframe_interval);
+    }
+    if (o.opening_tree) {
+        if (o.tree_depth > 0) {
+            printf("Árbol de aperturas: primeras %d jugadas de cada partida\n", o.tree_depth);
+        } else {
+            printf("Árbol de aperturas: partidas completas\n");
+        }
+    }
+    if (o.lazy && o.opening_tree) {
+        printf("Carga diferida desactivada: el árbol de aperturas necesita todas las partidas\n");
     }
     
-    printf("\n✓ Se cargaron %d partida(s)\n\n", col.game_count);
+    // El árbol de aperturas necesita todas las partidas validadas
+    LazyIndex lazy_index;
+    LazyIndex *lazy = (o.lazy && !o.opening_tree) ? &lazy_index : NULL;
+    
+    if (lazy) {
+        int rc = lazy_index_open(lazy, path, &col, &o);
+        if (rc == -2) {
+            fprintf(stderr, "No se puede abrir archivo PGN: %s\n", path);
+            pgn_collection_free(&col);
+            return -1;
+        }
+        if (rc < 0) {
+            fprintf(stderr, "Error de lectura en archivo PGN: %s\n", path);
+        }
+        printf("\n📇 Índice: %d partida(s); se validan al elegirlas o en segundo plano "
+               "(%d hilo(s))\n\n", col.game_count, lazy->thread_count);
+    } else {
+        if (load_pgn_games(path, &col, &o) != 0) {
+            pgn_collection_free(&col);
+            return -1;
+        }
+        printf("\n✓ Se cargaron %d partida(s)\n\n", col.game_count);
+    }
     
     if (col.game_count == 0) {
         printf("No se encontraron partidas válidas en el archivo\n");
+        if (lazy) lazy_index_close(lazy);
         pgn_collection_free(&col);
         return -1;
     }
     
+    int show_list = 1;
     while (1) {
-        printf("\n════════════════════════════════════════════════════════════\n");
-        printf("PARTIDAS DISPONIBLES:\n");
-        printf("════════════════════════════════════════════════════════════\n");
-        for (int i = 0; i < col.game_count; i++) {
-            printf("[%d] %s: %s vs %s (%d movimientos) - %s\n", 
-                   i + 1,
-                   col.games[i].event[0] ? col.games[i].event : "Sin título",
-                   col.games[i].white[0] ? col.games[i].white : "?",
-                   col.games[i].black[0] ? col.games[i].black : "?",
-                   col.games[i].move_count,
-                   col.games[i].result[0] ? col.games[i].result : "*");
-        }
-        printf("════════════════════════════════════════════════════════════\n");
+        if (show_list) {
+            printf("\n════════════════════════════════════════════════════════════\n");
+            printf("PARTIDAS DISPONIBLES:\n");
+            printf("════════════════════════════════════════════════════════════\n");
+            if (lazy) pthread_mutex_lock(&lazy->lock);
+            for (int i = 0; i < col.game_count; i++) {
+                print_game_entry(&col, i, lazy ? lazy->entries[i].state : LAZY_VALID);
+            }
+            if (lazy) {
+                printf("════════════════════════════════════════════════════════════\n");
+                printf("Validadas: %d/%d\n", lazy->validated, col.game_count);
+                pthread_mutex_unlock(&lazy->lock);
+            }
+            printf("════════════════════════════════════════════════════════════\n");
+        }
+        show_list = 1;
         
         char input[256];
         int selected = -1;
         
-        printf("\nSeleccione partida (1-%d) o 'q' para salir del programa: ", col.game_count);
+        if (col.tree.nodes) {
+            printf("\nSeleccione partida (1-%d), 'f <consulta>' para buscar, 'a' para el "
+                   "árbol de aperturas o 'q' para salir del programa: ", col.game_count);
+        } else {
+            printf("\nSeleccione partida (1-%d), 'f <consulta>' para buscar "
+                   "o 'q' para salir del programa: ", col.game_count);
+        }
         if (!fgets(input, sizeof(input), stdin)) break;
         
         input[strcspn(input, "\r\n")] = '\0';
         trim(input);
         
+        if (col.tree.nodes && strcmp(input, "a") == 0) {
+            explore_opening_tree(&col.tree);
+            continue;
+        }
+        
+        // Búsqueda por etiquetas: se vuelve a pedir la partida sin repetir la lista
+        if (input[0] == 'f' && (input[1] == ' ' || input[1] == '\0')) {
+            search_games(&col, input + 1, lazy);
+            show_list = 0;
+            continue;
+        }
+        
         if (strcmp(input, "q") == 0 || strcmp(input, "Q") == 0) {
             printf("\nSaliendo del programa...\n");
+            if (lazy) lazy_index_close(lazy);
             pgn_collection_free(&col);
             return 0;
         }
@@ -493,11 +1726,25 @@ int pgn_mode(const char *path) {
             continue;
         }
         
+        if (lazy) {
+            PGNGame *game = &col.games[selected];
+            int ok = lazy_ensure(lazy, selected);
+            LazyEntry *e = &lazy->entries[selected];
+            if (e->log.len) fwrite(e->log.data, 1, e->log.len, stderr);
+            if (!ok) {
+                printf("\nLa partida #%d no es válida y no se puede reproducir\n", selected + 1);
+                continue;
+            }
+            printf("✓ Partida #%d validada (%d movimientos)\n", selected + 1, game->move_count);
+            report_final_status(game);
+        }
+        
         replay_game(&col.games[selected]);
         
         printf("\n¿Desea ver otra partida? (Presione Enter para continuar)\n");
     }
     
+    if (lazy) lazy_index_close(lazy);
     pgn_collection_free(&col);
     return 0;
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 #include "ast.h"
 #include "semant.h"
+#include "opening_tree.h"
+#include "tag_index.h"
+#include "pgn_reader.h"
 
 // ============================================================================
 // ESTRUCTURAS
@@ -15,6 +18,7 @@ typedef struct {
     MoveAST ast;             // AST del movimiento parseado
     Board board_state;       // Estado del tablero DESPUÉS del movimiento
     Color side_to_move;      // Color que hizo el movimiento
+    Move code;               // Codificación de 16 bits del movimiento
 } GameMove;
 
 // Representa una partida completa de ajedrez
@@ -23,9 +27,20 @@ typedef struct {
     char white[128];         // Nombre del jugador blanco
     char black[128];         // Nombre del jugador negro
     char result[16];         // Resultado (1-0, 0-1, 1/2-1/2, *)
-    GameMove *moves;         // Array dinámico de movimientos
+    char fen[BOARD_FEN_MAX]; // [FEN] de la posición inicial ("" = posición estándar)
+    Color start_side;        // Bando que juega primero (según el FEN)
+    GameMove *moves;         // Array dinámico de movimientos (NULL en modo compacto)
     int move_count;          // Cantidad de movimientos
     int move_capacity;       // Capacidad del array
+
+    // Modo compacto: un código de 16 bits por jugada y un tablero clave
+    // cada 'keyframe_interval' jugadas; las posiciones se reconstruyen al
+    // reproducir la partida
+    Move *codes;             // Código de cada jugada
+    Board *keyframes;        // keyframes[k] = tablero tras (k + 1) * keyframe_interval jugadas
+    int keyframe_interval;   // 0 = modo normal (se usa 'moves')
+
+    PositionStatus final_status;  // Estado tras la última jugada (mate, tablas, ...)
 } PGNGame;
 
 // Colección de múltiples partidas
@@ -33,8 +48,44 @@ typedef struct {
     PGNGame *games;          // Array dinámico de partidas
     int game_count;          // Cantidad de partidas
     int game_capacity;       // Capacidad del array
+    OpeningTree tree;        // Árbol de aperturas (tree.nodes == NULL = no se construye)
+    TagIndex tags;           // Todas las etiquetas de games[i] (partida i del índice)
 } PGNCollection;
 
+// Intervalo por defecto entre tableros clave en modo compacto
+#define PGN_KEYFRAME_INTERVAL 128
+
+// Opciones del modo PGN
+typedef struct {
+    int compact;             // 1 = almacenamiento compacto de jugadas
+    int keyframe_interval;   // Jugadas entre tableros clave (0 = PGN_KEYFRAME_INTERVAL)
+    int use_mmap;            // 1 = proyectar el archivo en memoria (sin copias)
+    int jobs;                // Hilos de validación (1 = secuencial)
+    int opening_tree;        // 1 = construir el árbol de aperturas al cargar
+    int tree_depth;          // Jugadas por partida en el árbol (0 = todas)
+    int no_game_cache;       // 1 = no leer ni escribir la caché <archivo>.cgc
+    int lazy;                // 1 = indexar y validar cada partida al elegirla
+                             //     o en segundo plano (con 'jobs' hilos)
+} PGNOptions;
+
+// Tipo de error de una partida inválida
+typedef enum {
+    PGN_ERROR_NONE = 0,
+    PGN_ERROR_FEN,           // [FEN] inválido o posición ilegal
+    PGN_ERROR_LEXICAL,       // Símbolo no reconocido en una jugada
+    PGN_ERROR_SYNTAX,        // La jugada no cumple la gramática SAN
+    PGN_ERROR_SEMANTIC,      // Jugada ilegal en la posición
+    PGN_ERROR_EMPTY          // La partida no tiene jugadas
+} PGNErrorKind;
+
+// Error de validación de una partida
+typedef struct {
+    PGNErrorKind kind;
+    int ply;                 // Jugada con el error (desde 1), 0 si no corresponde
+    PGNView move;            // Texto de esa jugada (vista sobre el texto de jugadas)
+    char reason[256];        // Razón (la de board_apply_move en los errores semánticos)
+} PGNGameError;
+
 // ============================================================================
 // FUNCIONES PÚBLICAS
 // ============================================================================
@@ -42,6 +93,21 @@ typedef struct {
 // Inicializa una partida PGN
 void pgn_game_init(PGNGame *game);
 
+// Inicializa una partida PGN en modo compacto (keyframe_interval > 0)
+void pgn_game_init_compact(PGNGame *game, int keyframe_interval);
+
+// Reconstruye en 'out' la posición tras 'ply' jugadas (0 = posición inicial)
+void pgn_game_board_at(const PGNGame *game, int ply, Board *out);
+
+// Valida una partida (líneas de etiquetas y texto de jugadas) sin guardar
+// sus jugadas: deja en 'game' las etiquetas, la cantidad de jugadas y el
+// estado final. 0 = válida, -1 = inválida (el error queda en 'err')
+int pgn_validate_game(PGNGame *game, PGNView tags, PGNView movetext, PGNGameError *err);
+
+// Resultado que corresponde al final de la partida ("1-0", "0-1",
+// "1/2-1/2"), o NULL si el final no lo decide (abandono, acuerdo, ...)
+const char *pgn_game_expected_result(const PGNGame *game);
+
 // Libera memoria de una partida PGN
 void pgn_game_free(PGNGame *game);
 
@@ -55,4 +121,7 @@ void pgn_collection_free(PGNCollection *col);
 // Retorna 0 en éxito, -1 en error
 int pgn_mode(const char *path);
 
+// Igual que pgn_mode, con opciones (NULL = opciones por defecto)
+int pgn_mode_ex(const char *path, const PGNOptions *opts);
+
 #endif // PGN_H
\ No newline at end of file
@@ -0,0 +1,652 @@
+// pgn_reader.c - Lector incremental de archivos PGN
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "pgn_reader.h"
+
+// Clasificación vectorial del texto de jugadas (ver pgn_scanner_next)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SCAN_WIDTH 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_WIDTH 16
+#endif
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define PGN_CHUNK_SIZE (1 << 16)
+
+// Cada cuántos bytes procesados se liberan las páginas de la proyección
+#define PGN_RELEASE_SIZE (4 << 20)
+
+// ============================================================================
+// BUFFERS
+// ============================================================================
+
+// Asegura espacio para 'extra' bytes más el terminador
+static int buffer_reserve(PGNBuffer *b, size_t extra) {
+    if (b->len + extra + 1 <= b->cap) return 0;
+
+    size_t cap = b->cap ? b->cap : 256;
+    while (cap < b->len + extra + 1) cap *= 2;
+
+    char *data = realloc(b->data, cap);
+    if (!data) return -1;
+    b->data = data;
+    b->cap = cap;
+    return 0;
+}
+
+static int buffer_append(PGNBuffer *b, const char *s, size_t n) {
+    if (buffer_reserve(b, n) != 0) return -1;
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+    return 0;
+}
+
+static void buffer_clear(PGNBuffer *b) {
+    b->len = 0;
+    if (b->data) b->data[0] = '\0';
+}
+
+static void buffer_free(PGNBuffer *b) {
+    free(b->data);
+    b->data = NULL;
+    b->len = b->cap = 0;
+}
+
+// ============================================================================
+// LECTURA POR LÍNEAS
+// ============================================================================
+
+void pgn_reader_init(PGNReader *r, FILE *f) {
+    memset(r, 0, sizeof(*r));
+    r->f = f;
+}
+
+int pgn_reader_open(PGNReader *r, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    pgn_reader_init(r, f);
+    r->owns_file = 1;
+    return 0;
+}
+
+int pgn_reader_open_mmap(PGNReader *r, const char *path) {
+#if defined(_WIN32)
+    return pgn_reader_open(r, path);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Tuberías, dispositivos, etc.: lectura por bloques
+    if (!S_ISREG(st.st_mode)) {
+        close(fd);
+        return pgn_reader_open(r, path);
+    }
+
+    pgn_reader_init(r, NULL);
+
+    if (st.st_size == 0) {
+        close(fd);
+        r->map = "";
+        return 0;
+    }
+
+    void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return pgn_reader_open(r, path);
+
+    madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+    r->map = m;
+    r->map_len = (size_t)st.st_size;
+    return 0;
+#endif
+}
+
+void pgn_reader_close(PGNReader *r) {
+#if !defined(_WIN32)
+    if (r->map && r->map_len > 0) munmap((void *)r->map, r->map_len);
+#endif
+    r->map = NULL;
+    r->map_len = 0;
+    if (r->owns_file && r->f) fclose(r->f);
+    r->f = NULL;
+    free(r->chunk);
+    r->chunk = NULL;
+    buffer_free(&r->line);
+    buffer_free(&r->tags);
+    buffer_free(&r->movetext);
+}
+
+// Lee la siguiente línea completa en r->line (sin '\n').
+// 1 = hay línea, 0 = fin del archivo, -1 = error
+static int read_line(PGNReader *r) {
+    buffer_clear(&r->line);
+    r->line_offset = r->chunk_offset + (long)r->chunk_pos;
+    int got_any = 0;
+
+    while (1) {
+        if (r->chunk_pos >= r->chunk_len) {
+            if (r->eof) return got_any ? 1 : 0;
+            if (!r->chunk) {
+                r->chunk = malloc(PGN_CHUNK_SIZE);
+                if (!r->chunk) return -1;
+            }
+            r->chunk_offset += (long)r->chunk_len;
+            r->chunk_pos = 0;
+#if !defined(_WIN32)
+            if (r->streaming) {
+                // fread esperaría a llenar el bloque: se toma lo que haya
+                ssize_t got;
+                do {
+                    got = read(fileno(r->f), r->chunk, PGN_CHUNK_SIZE);
+                } while (got < 0 && errno == EINTR);
+                if (got < 0) return -1;
+                r->chunk_len = (size_t)got;
+            } else
+#endif
+            r->chunk_len = fread(r->chunk, 1, PGN_CHUNK_SIZE, r->f);
+            if (r->chunk_len == 0) {
+                if (ferror(r->f)) return -1;
+                r->eof = 1;
+                return got_any ? 1 : 0;
+            }
+            if (!got_any) r->line_offset = r->chunk_offset;
+        }
+
+        const char *start = r->chunk + r->chunk_pos;
+        size_t avail = r->chunk_len - r->chunk_pos;
+        const char *nl = memchr(start, '\n', avail);
+        size_t n = nl ? (size_t)(nl - start) : avail;
+
+        if (buffer_append(&r->line, start, n) != 0) return -1;
+        got_any = 1;
+        r->chunk_pos += n;
+
+        if (nl) {
+            r->chunk_pos++;   // saltar '\n'
+            return 1;
+        }
+    }
+}
+
+// Quita espacios al principio y al final de r->line; devuelve el inicio
+static char *trim_line(PGNReader *r) {
+    char *s = r->line.data;
+    size_t len = r->line.len;
+
+    while (len > 0 && isspace((unsigned char)s[len - 1])) s[--len] = '\0';
+    while (*s && isspace((unsigned char)*s)) s++;
+    return s;
+}
+
+// ============================================================================
+// PARTIDAS
+// ============================================================================
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+void pgn_reader_set_streaming(PGNReader *r, int on) {
+    r->streaming = on;
+}
+
+// Entrada en vivo: 1 si el texto de jugadas leído hasta ahora termina con el
+// resultado de la partida (después solo puede haber comentarios). Usa el
+// mismo recorrido que la validación (pgn_scanner_next) y sigue desde el
+// primer elemento que quedó abierto en la llamada anterior: un {comentario}
+// o una (variante) que aún no se cerró.
+static int movetext_ends_game(PGNReader *r) {
+    const char *end = r->movetext.data + r->movetext.len;
+    PGNView rest = { r->movetext.data + r->live_pos, r->movetext.len - r->live_pos };
+    PGNScanner scanner;
+    PGNToken tok;
+    pgn_scanner_init(&scanner, rest);
+
+    while (pgn_scanner_next(&scanner, &tok) != PGN_TOKEN_END) {
+        // Sin cierre: se vuelve a mirar cuando llegue la siguiente línea.
+        // Los comentarios con ';' terminan con la línea, que ya está completa
+        int open = (tok.kind == PGN_TOKEN_VARIATION ||
+                    (tok.kind == PGN_TOKEN_COMMENT && tok.text.ptr[-1] == '{')) &&
+                   tok.text.ptr + tok.text.len == end;
+        if (open) {
+            r->live_pos = (size_t)(tok.text.ptr - 1 - r->movetext.data);
+            return 0;
+        }
+        if (tok.kind != PGN_TOKEN_COMMENT) r->live_result = (tok.kind == PGN_TOKEN_RESULT);
+    }
+    r->live_pos = r->movetext.len;
+    return r->live_result;
+}
+
+// Modo mmap: mismas reglas que la lectura por bloques, pero las etiquetas y
+// las jugadas se devuelven como rangos de la proyección
+static int next_mapped(PGNReader *r, PGNRawGame *out) {
+#if !defined(_WIN32)
+    // Devolver al sistema las páginas ya procesadas para que la memoria
+    // residente no crezca con el archivo. Son páginas de un archivo de solo
+    // lectura: si se vuelve a acceder a ellas se releen del disco.
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t done = r->map_pos & ~(page - 1);
+    if (done - r->map_released >= PGN_RELEASE_SIZE) {
+        madvise((char *)r->map + r->map_released, done - r->map_released, MADV_DONTNEED);
+        r->map_released = done;
+    }
+#endif
+
+    int has_current_game = 0;
+    int in_moves = 0;
+    int tag_count = 0;
+    size_t game_offset = 0;
+    const char *tags_start = NULL, *tags_end = NULL;
+    const char *moves_start = NULL, *moves_end = NULL;
+
+    while (r->map_pos < r->map_len) {
+        const char *ls = r->map + r->map_pos;
+        const char *nl = memchr(ls, '\n', r->map_len - r->map_pos);
+        const char *le = nl ? nl : r->map + r->map_len;
+
+        // Línea sin espacios al principio ni al final: [s, e)
+        const char *s = ls, *e = le;
+        while (e > s && is_space(e[-1])) e--;
+        while (s < e && is_space(*s)) s++;
+        size_t n = (size_t)(e - s);
+
+        if (n >= 7 && memcmp(s, "[Event ", 7) == 0) {
+            // La línea [Event ...] se queda para la siguiente partida
+            if (has_current_game && moves_start) break;
+
+            tags_start = tags_end = NULL;
+            moves_start = moves_end = NULL;
+            tag_count = 0;
+            in_moves = 0;
+            has_current_game = 1;
+            game_offset = (size_t)(ls - r->map);
+        }
+
+        r->map_pos = (size_t)(le - r->map) + (nl ? 1 : 0);
+
+        if (n > 0 && s[0] == '[' && has_current_game) {
+            if (!tags_start) tags_start = s;
+            tags_end = e;
+            tag_count++;
+            in_moves = 0;
+        }
+        else if (n == 0 && has_current_game) {
+            in_moves = 1;
+        }
+        else if (in_moves && n > 0 && has_current_game) {
+            if (!moves_start) moves_start = s;
+            moves_end = e;
+        }
+    }
+
+    if (!has_current_game || !moves_start) return 0;
+
+    out->tags.ptr = tags_start;
+    out->tags.len = tags_start ? (size_t)(tags_end - tags_start) : 0;
+    out->tag_count = tag_count;
+    out->movetext.ptr = moves_start;
+    out->movetext.len = (size_t)(moves_end - moves_start);
+    out->offset = (long)game_offset;
+    return 1;
+}
+
+int pgn_reader_next(PGNReader *r, PGNRawGame *out) {
+    if (r->map) return next_mapped(r, out);
+
+    int has_current_game = 0;
+    int in_moves = 0;
+    long game_offset = 0;
+
+    buffer_clear(&r->tags);
+    buffer_clear(&r->movetext);
+    r->tag_count = 0;
+
+    while (1) {
+        char *line;
+
+        if (r->pending_event) {
+            // [Event ...] leído en la llamada anterior
+            r->pending_event = 0;
+            line = r->line.data;
+        } else {
+            int rc = read_line(r);
+            if (rc < 0) return -1;
+            if (rc == 0) break;
+            line = trim_line(r);
+        }
+
+        if (strncmp(line, "[Event ", 7) == 0) {
+            if (has_current_game && r->movetext.len > 0) {
+                // Entregar la partida actual; esta línea abre la siguiente
+                if (line != r->line.data) memmove(r->line.data, line, strlen(line) + 1);
+                r->pending_event = 1;
+                break;
+            }
+
+            // Nueva partida (una anterior sin jugadas se descarta)
+            buffer_clear(&r->tags);
+            buffer_clear(&r->movetext);
+            r->tag_count = 0;
+            r->live_pos = 0;
+            r->live_result = 0;
+            in_moves = 0;
+            has_current_game = 1;
+            game_offset = r->line_offset;
+        }
+
+        if (line[0] == '[' && has_current_game) {
+            if (buffer_append(&r->tags, line, strlen(line)) != 0 ||
+                buffer_append(&r->tags, "\n", 1) != 0) return -1;
+            r->tag_count++;
+            in_moves = 0;
+        }
+        else if (line[0] == '\0' && has_current_game) {
+            in_moves = 1;
+        }
+        else if (in_moves && line[0] != '\0' && has_current_game) {
+            // Las líneas se separan con '\n': un comentario ';' llega hasta él
+            if (buffer_append(&r->movetext, "\n", 1) != 0 ||
+                buffer_append(&r->movetext, line, strlen(line)) != 0) return -1;
+
+            // En vivo la partida termina con su resultado, sin esperar a la siguiente
+            if (r->streaming && movetext_ends_game(r)) break;
+        }
+    }
+
+    if (!has_current_game || r->movetext.len == 0) return 0;
+
+    out->tags.ptr = r->tags.data;
+    out->tags.len = r->tags.len;
+    out->tag_count = r->tag_count;
+    out->movetext.ptr = r->movetext.data;
+    out->movetext.len = r->movetext.len;
+    out->offset = game_offset;
+    return 1;
+}
+
+// ============================================================================
+// ETIQUETAS
+// ============================================================================
+
+int pgn_next_tag(PGNView *block, PGNView *name, PGNView *value) {
+    const char *p = block->ptr;
+    const char *end = block->ptr + block->len;
+
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *le = nl ? nl : end;
+        const char *s = p, *e = le;
+        p = nl ? nl + 1 : end;
+
+        while (e > s && is_space(e[-1])) e--;
+        while (s < e && is_space(*s)) s++;
+        if (s == e || *s != '[') continue;
+
+        // Nombre: desde '[' hasta el primer espacio
+        const char *n = s + 1;
+        while (n < e && !is_space(*n) && *n != '"' && *n != ']') n++;
+        name->ptr = s + 1;
+        name->len = (size_t)(n - (s + 1));
+
+        // Valor: entre la primera y la última comilla de la línea
+        const char *q1 = memchr(s, '"', (size_t)(e - s));
+        const char *q2 = e;
+        while (q2 > s && q2[-1] != '"') q2--;
+        if (q1 && q2 > s && q2 - 1 > q1) {
+            value->ptr = q1 + 1;
+            value->len = (size_t)(q2 - 1 - (q1 + 1));
+        } else {
+            value->ptr = NULL;
+            value->len = 0;
+        }
+
+        block->ptr = p;
+        block->len = (size_t)(end - p);
+        return 1;
+    }
+
+    block->ptr = end;
+    block->len = 0;
+    return 0;
+}
+
+// ============================================================================
+// TEXTO DE JUGADAS
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// El texto se clasifica por bloques de 64 bytes: con SSE2/AVX2 se comparan
+// 16/32 bytes a la vez y el resultado queda en dos máscaras (bit i = byte i
+// del bloque). Buscar el inicio o el fin de una jugada es entonces contar
+// ceros de la máscara, sin revisar byte a byte. Cerca del final del texto
+// (o sin SIMD) se usa el recorrido byte a byte.
+// ----------------------------------------------------------------------------
+
+#define SCAN_BLOCK 64
+
+#ifdef SCAN_WIDTH
+#if SCAN_WIDTH == 32
+typedef __m256i ScanVec;
+#define scan_load(p)      _mm256_loadu_si256((const __m256i *)(p))
+#define scan_eq(v, c)     _mm256_cmpeq_epi8((v), _mm256_set1_epi8(c))
+#define scan_or(a, b)     _mm256_or_si256((a), (b))
+#define scan_in(v, lo, hi) _mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_max_epu8((v), \
+                              _mm256_set1_epi8(lo)), _mm256_set1_epi8(hi)), (v))
+#define scan_bits(v)      ((uint64_t)(uint32_t)_mm256_movemask_epi8(v))
+#else
+typedef __m128i ScanVec;
+#define scan_load(p)      _mm_loadu_si128((const __m128i *)(p))
+#define scan_eq(v, c)     _mm_cmpeq_epi8((v), _mm_set1_epi8(c))
+#define scan_or(a, b)     _mm_or_si128((a), (b))
+#define scan_in(v, lo, hi) _mm_cmpeq_epi8(_mm_min_epu8(_mm_max_epu8((v), \
+                              _mm_set1_epi8(lo)), _mm_set1_epi8(hi)), (v))
+#define scan_bits(v)      ((uint64_t)(uint32_t)_mm_movemask_epi8(v))
+#endif
+
+// Clasifica los 64 bytes desde p (deben ser legibles)
+static void scanner_classify(PGNScanner *s, const char *p) {
+    uint64_t skip = 0, stop = 0;
+    for (int i = 0; i < SCAN_BLOCK; i += SCAN_WIDTH) {
+        ScanVec v = scan_load(p + i);
+        // Espacios: ' ' y '\t'..'\r'; '}' y ')' sueltos también se saltan
+        ScanVec sp = scan_or(scan_eq(v, ' '), scan_in(v, '\t', '\r'));
+        ScanVec sk = scan_or(sp, scan_or(scan_eq(v, '}'), scan_eq(v, ')')));
+        ScanVec st = scan_or(sk, scan_or(scan_eq(v, '{'), scan_eq(v, '(')));
+        st = scan_or(st, scan_or(scan_eq(v, '.'), scan_eq(v, ';')));
+        skip |= scan_bits(sk) << i;
+        stop |= scan_bits(st) << i;
+    }
+    s->block = p;
+    s->skip = skip;
+    s->stop = stop;
+}
+
+// Deja clasificado el bloque que contiene p. 0 si quedan menos de 64 bytes
+static int scanner_block_at(PGNScanner *s, const char *p) {
+    if (s->block && p >= s->block && p < s->block + SCAN_BLOCK) return 1;
+    if (s->end - p < SCAN_BLOCK) return 0;
+    scanner_classify(s, p);
+    return 1;
+}
+#endif
+
+static int is_skip_char(char c) {
+    return is_space(c) || c == '}' || c == ')';
+}
+
+// Primer byte desde p que no es espacio ni cierre suelto
+static const char *skip_separators(PGNScanner *s, const char *p) {
+#ifdef SCAN_WIDTH
+    while (scanner_block_at(s, p)) {
+        uint64_t rest = ~s->skip >> (p - s->block);
+        if (rest) return p + __builtin_ctzll(rest);
+        p = s->block + SCAN_BLOCK;
+    }
+#endif
+    while (p < s->end && is_skip_char(*p)) p++;
+    return p;
+}
+
+// Si la jugada que empezó en 'start' termina en q, devuelve dónde termina;
+// si no, NULL. Termina en un separador o donde empieza un número de jugada
+// pegado ("e4" en "e412."); 'start' nunca es un número de jugada.
+static const char *token_end_at(const char *q, const char *start) {
+    char c = *q;
+    if (is_space(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';') return q;
+    if (c != '.') return NULL;
+
+    const char *r = q;
+    while (r > start && isdigit((unsigned char)r[-1])) r--;
+    return (r < q) ? r : NULL;
+}
+
+// Fin de la jugada que empieza en 'start'
+static const char *find_token_end(PGNScanner *s, const char *start) {
+    const char *p = start;
+#ifdef SCAN_WIDTH
+    while (scanner_block_at(s, p)) {
+        uint64_t cand = s->stop >> (p - s->block);
+        while (cand) {
+            const char *stop = token_end_at(p + __builtin_ctzll(cand), start);
+            if (stop) return stop;
+            cand &= cand - 1;
+        }
+        p = s->block + SCAN_BLOCK;
+    }
+#endif
+    for (; p < s->end; p++) {
+        const char *stop = token_end_at(p, start);
+        if (stop) return stop;
+    }
+    return s->end;
+}
+
+void pgn_scanner_init(PGNScanner *s, PGNView movetext) {
+    s->p = movetext.ptr;
+    s->end = movetext.ptr + movetext.len;
+    s->block = NULL;
+    s->skip = 0;
+    s->stop = 0;
+}
+
+// 1 si en p empieza un número de jugada ("12." o "12...")
+static int is_move_number(const char *p, const char *end) {
+    if (!isdigit((unsigned char)*p)) return 0;
+    while (p < end && isdigit((unsigned char)*p)) p++;
+    return p < end && *p == '.';
+}
+
+static int is_result(const char *p, size_t n) {
+    return (n == 3 && memcmp(p, "1-0", 3) == 0) ||
+           (n == 3 && memcmp(p, "0-1", 3) == 0) ||
+           (n == 7 && memcmp(p, "1/2-1/2", 7) == 0) ||
+           (n == 1 && *p == '*');
+}
+
+PGNTokenKind pgn_scanner_next(PGNScanner *s, PGNToken *tok) {
+    const char *p = s->p;
+    const char *end = s->end;
+
+    while (p < end) {
+        // Separadores y cierres sueltos
+        p = skip_separators(s, p);
+        if (p >= end) break;
+        char c = *p;
+
+        // Comentario {...}
+        if (c == '{') {
+            const char *close = memchr(p + 1, '}', (size_t)(end - p - 1));
+            const char *stop = close ? close : end;
+            tok->kind = PGN_TOKEN_COMMENT;
+            tok->text.ptr = p + 1;
+            tok->text.len = (size_t)(stop - (p + 1));
+            s->p = close ? close + 1 : end;
+            return tok->kind;
+        }
+
+        // Comentario ;... hasta el fin de la línea
+        if (c == ';') {
+            const char *nl = memchr(p + 1, '\n', (size_t)(end - p - 1));
+            const char *stop = nl ? nl : end;
+            tok->kind = PGN_TOKEN_COMMENT;
+            tok->text.ptr = p + 1;
+            tok->text.len = (size_t)(stop - (p + 1));
+            s->p = stop;
+            return tok->kind;
+        }
+
+        // Variante (...), con anidamiento; los comentarios internos se saltan
+        if (c == '(') {
+            const char *q = p + 1;
+            int depth = 1;
+            while (q < end && depth > 0) {
+                if (*q == '{') {
+                    const char *close = memchr(q + 1, '}', (size_t)(end - q - 1));
+                    q = close ? close + 1 : end;
+                    continue;
+                }
+                if (*q == ';') {
+                    const char *nl = memchr(q + 1, '\n', (size_t)(end - q - 1));
+                    q = nl ? nl : end;
+                    continue;
+                }
+                if (*q == '(') depth++;
+                else if (*q == ')') depth--;
+                q++;
+            }
+            tok->kind = PGN_TOKEN_VARIATION;
+            tok->text.ptr = p + 1;
+            tok->text.len = (size_t)((depth == 0 ? q - 1 : q) - (p + 1));
+            s->p = q;
+            return tok->kind;
+        }
+
+        // Etiqueta fuera de lugar dentro de las jugadas: se ignora
+        if (c == '[') {
+            const char *close = memchr(p, ']', (size_t)(end - p));
+            p = close ? close + 1 : end;
+            continue;
+        }
+
+        // Número de jugada
+        if (is_move_number(p, end)) {
+            while (p < end && isdigit((unsigned char)*p)) p++;
+            while (p < end && *p == '.') p++;
+            continue;
+        }
+
+        // Jugada o resultado: hasta el siguiente separador
+        const char *start = p;
+        p = find_token_end(s, start);
+
+        tok->text.ptr = start;
+        tok->text.len = (size_t)(p - start);
+        tok->kind = is_result(start, tok->text.len) ? PGN_TOKEN_RESULT : PGN_TOKEN_SAN;
+        s->p = p;
+        return tok->kind;
+    }
+
+    s->p = end;
+    tok->kind = PGN_TOKEN_END;
+    tok->text.ptr = end;
+    tok->text.len = 0;
+    return PGN_TOKEN_END;
+}
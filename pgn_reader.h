@@ -0,0 +1,133 @@
+// pgn_reader.h - Lector incremental de archivos PGN
+//
+// Lee el archivo por bloques y entrega una partida cada vez (etiquetas y
+// texto de jugadas), sin límites de longitud de línea ni de partida. La
+// memoria usada solo depende de la partida más larga, no del archivo.
+//
+// En modo mmap (pgn_reader_open_mmap) el archivo se proyecta en memoria y
+// las partidas, etiquetas y jugadas son vistas (puntero, longitud) sobre
+// la proyección, sin copias.
+#ifndef PGN_READER_H
+#define PGN_READER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Vista sobre el texto de entrada (no termina en '\0')
+typedef struct {
+    const char *ptr;
+    size_t len;
+} PGNView;
+
+// Partida leída (sin validar). Las vistas apuntan a buffers del lector (o
+// a la proyección en modo mmap) y son válidas hasta la siguiente llamada
+// a pgn_reader_next (en modo mmap, hasta pgn_reader_close).
+typedef struct {
+    PGNView tags;            // Líneas de etiquetas ("[Clave \"Valor\"]") separadas por '\n'
+    int tag_count;           // Cantidad de etiquetas
+    PGNView movetext;        // Texto de jugadas
+    long offset;             // Posición en el archivo de la línea [Event ...]
+} PGNRawGame;
+
+// Búfer que crece según se necesita
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} PGNBuffer;
+
+// Estado del lector
+typedef struct {
+    FILE *f;
+    int owns_file;           // 1 si el lector abrió el archivo y debe cerrarlo
+
+    const char *map;         // Proyección del archivo (modo mmap), NULL si no
+    size_t map_len;
+    size_t map_pos;          // Inicio de la siguiente línea en la proyección
+    size_t map_released;     // Bytes iniciales ya devueltos al sistema (madvise)
+
+    char *chunk;             // Bloque leído del archivo
+    size_t chunk_len;        // Bytes válidos en 'chunk'
+    size_t chunk_pos;        // Siguiente byte por consumir
+    long chunk_offset;       // Posición en el archivo del inicio de 'chunk'
+
+    PGNBuffer line;          // Línea actual
+    long line_offset;        // Posición en el archivo de la línea actual
+    int pending_event;       // 1 si 'line' es un [Event ...] aún no procesado
+    int eof;
+
+    // Entrada en vivo (ver pgn_reader_set_streaming)
+    int streaming;
+    size_t live_pos;         // Inicio en 'movetext' de lo que falta recorrer
+    int live_result;         // 1 si el último elemento recorrido es el resultado
+
+    PGNBuffer tags;          // Etiquetas de la partida actual
+    int tag_count;
+    PGNBuffer movetext;      // Jugadas de la partida actual
+} PGNReader;
+
+// Abre 'path' para lectura. 0 = éxito, -1 = error
+int pgn_reader_open(PGNReader *r, const char *path);
+
+// Abre 'path' en modo mmap (en sistemas sin mmap, lectura por bloques).
+// 0 = éxito, -1 = error
+int pgn_reader_open_mmap(PGNReader *r, const char *path);
+
+// Lee desde un FILE* ya abierto (por ejemplo stdin); no lo cierra
+void pgn_reader_init(PGNReader *r, FILE *f);
+
+// Entrada en vivo (stdin, FIFO): cada lectura devuelve lo que ya llegó, sin
+// esperar a llenar un bloque, y la partida se entrega en cuanto aparece su
+// resultado (1-0, 0-1, 1/2-1/2 o *) en lugar de esperar al [Event ...] de
+// la siguiente. No tiene efecto en modo mmap
+void pgn_reader_set_streaming(PGNReader *r, int on);
+
+// Lee la siguiente partida.
+// 1 = hay partida en 'out', 0 = fin del archivo, -1 = error de lectura
+int pgn_reader_next(PGNReader *r, PGNRawGame *out);
+
+// Libera los buffers (y cierra el archivo si lo abrió el lector)
+void pgn_reader_close(PGNReader *r);
+
+// ============================================================================
+// ETIQUETAS Y TEXTO DE JUGADAS
+// ============================================================================
+
+// Extrae la siguiente etiqueta de 'block' (lo consume hasta ella).
+// name = "Event", value = texto entre la primera y la última comilla.
+// 1 = hay etiqueta, 0 = no quedan
+int pgn_next_tag(PGNView *block, PGNView *name, PGNView *value);
+
+// Tipos de elemento del texto de jugadas
+typedef enum {
+    PGN_TOKEN_END = 0,       // No quedan elementos
+    PGN_TOKEN_SAN,           // Jugada (posible SAN)
+    PGN_TOKEN_RESULT,        // 1-0, 0-1, 1/2-1/2 o *
+    PGN_TOKEN_COMMENT,       // {comentario} sin llaves, o ;comentario hasta el fin de línea
+    PGN_TOKEN_VARIATION      // (variante), sin paréntesis; pueden anidarse
+} PGNTokenKind;
+
+typedef struct {
+    PGNTokenKind kind;
+    PGNView text;
+} PGNToken;
+
+// Recorre el texto de jugadas sin copiarlo; los números de jugada
+// ("12." / "12...") se descartan
+typedef struct {
+    const char *p;
+    const char *end;
+
+    // Bloque de 64 bytes ya clasificado (con SSE2/AVX2): bit i = byte i
+    const char *block;       // NULL = ninguno
+    uint64_t skip;           // Separadores entre jugadas (espacios, '}', ')')
+    uint64_t stop;           // Posibles fines de jugada (separadores, '{', '(', '.', ';')
+} PGNScanner;
+
+void pgn_scanner_init(PGNScanner *s, PGNView movetext);
+
+// Siguiente elemento del texto de jugadas; devuelve su tipo
+PGNTokenKind pgn_scanner_next(PGNScanner *s, PGNToken *tok);
+
+#endif // PGN_READER_H
@@ -1,6 +1,9 @@
 #include <stdio.h>
 #include <string.h>
 #include "semant.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include "status_cache.h"
 
 
 // Convierte columna de caracter a índice
@@ -19,17 +22,100 @@ int rank_to_index(char rank_char) {
     return rank_char - '1';
 }
 
-// Mueve una pieza a una casilla (rank, file)
+// Codificación de una casilla en Board.squares: (color << 3) | tipo
+#define SQ(r, f)          ((r) * 8 + (f))
+#define SQ_BIT(sq)        ((Bitboard)1 << (sq))
+#define SQ_CODE(c, t)     ((unsigned char)(((c) << 3) | (t)))
+#define CODE_TYPE(code)   ((PieceType)((code) & 7))
+#define CODE_COLOR(code)  ((Color)((code) >> 3))
+
+// Índice del bit menos significativo (bb != 0)
+static inline int bb_lsb(Bitboard bb) {
+    return __builtin_ctzll(bb);
+}
+
+// Extrae y devuelve el bit menos significativo (bb != 0)
+static inline int bb_pop_lsb(Bitboard *bb) {
+    int sq = __builtin_ctzll(*bb);
+    *bb &= *bb - 1;
+    return sq;
+}
+
+// Tipo de pieza en (r, f)
+static inline PieceType type_at(const Board *b, int r, int f) {
+    return CODE_TYPE(b->squares[SQ(r, f)]);
+}
+
+// Color de la pieza en (r, f)
+static inline Color color_at(const Board *b, int r, int f) {
+    return CODE_COLOR(b->squares[SQ(r, f)]);
+}
+
+// Pieza en (r, f) sin validar límites
+static inline Piece piece_at(const Board *b, int r, int f) {
+    unsigned char code = b->squares[SQ(r, f)];
+    Piece p = { CODE_COLOR(code), CODE_TYPE(code) };
+    return p;
+}
+
+// Devuelve la pieza en (rank, file)
+Piece board_piece_at(const Board *b, int rank, int file) {
+    Piece p = { COLOR_NONE, PIECE_NONE };
+    if (!b || rank < 0 || rank > 7 || file < 0 || file > 7) return p;
+    unsigned char code = b->squares[SQ(rank, file)];
+    p.color = CODE_COLOR(code);
+    p.type  = CODE_TYPE(code);
+    return p;
+}
+
+// Quita la pieza de la casilla sq (si la hay)
+static void remove_piece(Board *b, int sq) {
+    unsigned char code = b->squares[sq];
+    if (!code) return;
+    Bitboard bit = SQ_BIT(sq);
+    int ci = CODE_COLOR(code) - 1;
+    b->pieces[ci][CODE_TYPE(code) - 1] &= ~bit;
+    b->occupied[ci] &= ~bit;
+    b->occupied_all &= ~bit;
+    b->squares[sq] = 0;
+    b->hash ^= ZOBRIST_PIECE(code, sq);
+}
+
+// Mueve una pieza a una casilla (rank, file), reemplazando lo que hubiera
 static void set_piece(Board *b, int rank, int file, Color color, PieceType type) {
-    b->board[rank][file].color = color;
-    b->board[rank][file].type = type;
+    int sq = SQ(rank, file);
+    remove_piece(b, sq);
+    if (type == PIECE_NONE || color == COLOR_NONE) return;
+
+    Bitboard bit = SQ_BIT(sq);
+    b->pieces[color - 1][type - 1] |= bit;
+    b->occupied[color - 1] |= bit;
+    b->occupied_all |= bit;
+    b->squares[sq] = SQ_CODE(color, type);
+    b->hash ^= ZOBRIST_PIECE(b->squares[sq], sq);
+}
+
+// Traslada la pieza de 'from' a 'to' (lo que hubiera en 'to' se pierde)
+static void move_piece(Board *b, int from, int to) {
+    unsigned char code = b->squares[from];
+    remove_piece(b, from);
+    set_piece(b, to / 8, to % 8, CODE_COLOR(code), CODE_TYPE(code));
+}
+
+// Vacía el tablero (piezas y máscaras)
+static void board_clear(Board *b) {
+    attacks_init(); // tablas de ataque listas antes de la primera posición
+    zobrist_init();
+    memset(b, 0, sizeof(*b));
+    b->en_passant_file = -1;
+    b->en_passant_rank = -1;
 }
 
 // Inicializa el tablero en la posición inicial estándar de ajedrez
 void board_init_start(Board *b) {
     if (!b) return;
 
-    memset(b->board, 0, sizeof(b->board)); // 1) Vaciar el tablero
+    board_clear(b); // 1) Vaciar el tablero
 
     // 2) Poner piezas blancas
     int r;      // columna
@@ -74,188 +160,320 @@ void board_init_start(Board *b) {
 
     b->en_passant_file = -1;
     b->en_passant_rank = -1;
+
+    b->hash = board_compute_hash(b, COLOR_WHITE);
 }
 
 // Inicializa el tablero en una posición de ahogado para pruebas
 void board_init_stalemate_test(Board *b)
 {
-    // Vaciar todo
+    // Vaciar todo (también quita enroques y en passant)
+    board_clear(b);
+
+    // Colocar rey blanco en h6 (fila 5, columna 7)
+    set_piece(b, 5, 7, COLOR_WHITE, PIECE_KING);
+
+    // Colocar dama blanca en g6 (fila 5, columna 6)
+    set_piece(b, 5, 6, COLOR_WHITE, PIECE_QUEEN);
+
+    // Colocar rey negro en h8 (fila 7, columna 7)
+    set_piece(b, 7, 7, COLOR_BLACK, PIECE_KING);
+
+    b->hash = board_compute_hash(b, COLOR_WHITE);
+}
+
+// Construye el tablero de bitboards a partir de la matriz 8x8
+void board_from_grid(Board *b, const BoardGrid *g)
+{
+    if (!b || !g) return;
+
+    board_clear(b);
     for (int r = 0; r < 8; ++r) {
         for (int f = 0; f < 8; ++f) {
-            b->board[r][f].type  = PIECE_NONE;
-            b->board[r][f].color = COLOR_NONE;
+            set_piece(b, r, f, g->board[r][f].color, g->board[r][f].type);
         }
     }
 
-    // Colocar rey blanco en h6 (fila 5, columna 7)
-    b->board[5][7].type  = PIECE_KING;
-    b->board[5][7].color = COLOR_WHITE;
+    b->white_can_castle_short = (unsigned char)(g->white_can_castle_short != 0);
+    b->white_can_castle_long  = (unsigned char)(g->white_can_castle_long != 0);
+    b->black_can_castle_short = (unsigned char)(g->black_can_castle_short != 0);
+    b->black_can_castle_long  = (unsigned char)(g->black_can_castle_long != 0);
+    b->en_passant_file = (signed char)g->en_passant_file;
+    b->en_passant_rank = (signed char)g->en_passant_rank;
+    b->hash = board_compute_hash(b, COLOR_WHITE);
+}
 
-    // Colocar dama blanca en g6 (fila 5, columna 6)
-    b->board[5][6].type  = PIECE_QUEEN;
-    b->board[5][6].color = COLOR_WHITE;
+// Vuelca el tablero de bitboards a la matriz 8x8
+void board_to_grid(const Board *b, BoardGrid *g)
+{
+    if (!b || !g) return;
 
-    // Colocar rey negro en h8 (fila 7, columna 7)
-    b->board[7][7].type  = PIECE_KING;
-    b->board[7][7].color = COLOR_BLACK;
-
-    // Sin enroques ni en passant
-    b->white_can_castle_short = 0;
-    b->white_can_castle_long  = 0;
-    b->black_can_castle_short = 0;
-    b->black_can_castle_long  = 0;
-    b->en_passant_file = -1;
-    b->en_passant_rank = -1;
+    for (int r = 0; r < 8; ++r) {
+        for (int f = 0; f < 8; ++f) {
+            g->board[r][f] = board_piece_at(b, r, f);
+        }
+    }
+
+    g->white_can_castle_short = b->white_can_castle_short;
+    g->white_can_castle_long  = b->white_can_castle_long;
+    g->black_can_castle_short = b->black_can_castle_short;
+    g->black_can_castle_long  = b->black_can_castle_long;
+    g->en_passant_file = b->en_passant_file;
+    g->en_passant_rank = b->en_passant_rank;
 }
 
 // Valida si la casilla (r,f) está atacada por el bando 'by_side'
+// Cada tipo de pieza se consulta con una tabla precalculada (attacks.h)
 // 1 = está atacada
 // 0 = no está atacada
 static int is_square_attacked(const Board *b, int r, int f, Color by_side)
 {
-    if (!b) return 0;
-
-    Color enemy = by_side;
-
-    // 1) Ataques de peones
-    if (enemy == COLOR_WHITE) {
-        // Peón blanco ataca (r+1, f-1) y (r+1, f+1)
-        int pr = r - 1;
-        if (pr >= 0) {
-            if (f - 1 >= 0) {
-                const Piece *p = &b->board[pr][f-1];
-                if (p->color == COLOR_WHITE && p->type == PIECE_PAWN) return 1;
-            }
-            if (f + 1 < 8) {
-                const Piece *p = &b->board[pr][f+1];
-                if (p->color == COLOR_WHITE && p->type == PIECE_PAWN) return 1;
+    if (!b || by_side == COLOR_NONE) return 0;
+
+    const Bitboard *enemy = b->pieces[by_side - 1];
+    int sq = SQ(r, f);
+
+    // 1) Ataques de peones: un peón enemigo ataca sq si está en una casilla
+    //    que un peón propio atacaría desde sq
+    Color own = (by_side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    if (pawn_attacks(own, sq) & enemy[PIECE_PAWN - 1]) return 1;
+
+    // 2) Ataques de caballos
+    if (knight_attacks(sq) & enemy[PIECE_KNIGHT - 1]) return 1;
+
+    // 3) Ataques del rey enemigo
+    if (king_attacks(sq) & enemy[PIECE_KING - 1]) return 1;
+
+    Bitboard queens = enemy[PIECE_QUEEN - 1];
+
+    // 4) Ataques en líneas rectas (torres y damas)
+    Bitboard straight = enemy[PIECE_ROOK - 1] | queens;
+    if (straight && (rook_attacks(sq, b->occupied_all) & straight)) return 1;
+
+    // 5) Ataques en diagonales (alfiles y damas)
+    Bitboard diag = enemy[PIECE_BISHOP - 1] | queens;
+    if (diag && (bishop_attacks(sq, b->occupied_all) & diag)) return 1;
+
+    return 0;
+}
+
+int board_is_square_attacked(const Board *b, int rank, int file, Color by_side)
+{
+    if (rank < 0 || rank > 7 || file < 0 || file > 7) return 0;
+    return is_square_attacked(b, rank, file, by_side);
+}
+
+// Verifica si el rey del bando del color 'side' está en jaque
+// 1 = en jaque
+// 0 = no en jaque
+static int is_king_in_check(const Board *b, Color side)
+{
+    if (!b || side == COLOR_NONE) return 0;
+
+    Bitboard king = b->pieces[side - 1][PIECE_KING - 1];
+
+    if (!king) {
+        // Posición ilegal (no hay rey), pero por ahora devolvemos "no en jaque"
+        return 0;
+    }
+
+    int ks = bb_lsb(king);
+    Color enemy = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    return is_square_attacked(b, ks / 8, ks % 8, enemy);
+}
+
+// Actualiza los derechos de enroque cuando una pieza de 'side' se mueve
+static void update_castling_rights_on_move(Board *b,
+                                           Color side,
+                                           PieceType pt,
+                                           int sr, int sf)
+{
+    if (!b) return;
+
+    if (side == COLOR_WHITE) {
+        if (pt == PIECE_KING) { // Si el rey se mueve pierde ambos enroques
+            b->white_can_castle_short = 0;
+            b->white_can_castle_long  = 0;
+        } else if (pt == PIECE_ROOK && sr == 0) { // Se mueve torre blanca
+            if (sf == 0) {          // Torre de a1
+                b->white_can_castle_long = 0;
+            } else if (sf == 7) {   // Torre de h1
+                b->white_can_castle_short = 0;
             }
         }
-    } else if (enemy == COLOR_BLACK) {
-        // Peón negro ataca (r-1, f-1) y (r-1, f+1)
-        int pr = r + 1;
-        if (pr < 8) {
-            if (f - 1 >= 0) {
-                const Piece *p = &b->board[pr][f-1];
-                if (p->color == COLOR_BLACK && p->type == PIECE_PAWN) return 1;
-            }
-            if (f + 1 < 8) {
-                const Piece *p = &b->board[pr][f+1];
-                if (p->color == COLOR_BLACK && p->type == PIECE_PAWN) return 1;
+    } else if (side == COLOR_BLACK) {
+        if (pt == PIECE_KING) { // Si el rey se mueve pierde ambos enroques
+            b->black_can_castle_short = 0;
+            b->black_can_castle_long  = 0;
+        } else if (pt == PIECE_ROOK && sr == 7) { // Se mueve torre negra
+            if (sf == 0) {          // Torre de a8
+                b->black_can_castle_long = 0;
+            } else if (sf == 7) {   // Torre de h8
+                b->black_can_castle_short = 0;
             }
         }
     }
+}
 
-    // 2) Ataques de caballos 
-    const int knight_moves[8][2] = {
-        { 2, 1}, { 2,-1}, {-2, 1}, {-2,-1},
-        { 1, 2}, { 1,-2}, {-1, 2}, {-1,-2}
-    };
-    // Recorre los posibles movimientos del caballo
-    for (int k = 0; k < 8; ++k) {
-        int rr = r + knight_moves[k][0];
-        int ff = f + knight_moves[k][1];
-        if (rr < 0 || rr >= 8 || ff < 0 || ff >= 8) continue;
-        const Piece *p = &b->board[rr][ff];
-        if (p->color == enemy && p->type == PIECE_KNIGHT) return 1;
-    }
-
-    // 3) Ataques en líneas rectas (torres y damas)
-    const int dirs_straight[4][2] = {
-        { 1, 0}, {-1, 0}, { 0, 1}, { 0,-1}
-    };
-    // Recorre las 4 direcciones rectas
-    for (int d = 0; d < 4; ++d) {
-        int dr = dirs_straight[d][0];
-        int df = dirs_straight[d][1];
-        int rr = r + dr;
-        int ff = f + df;
-        // Avanza en esa dirección hasta que se salga del tablero o encuentre una pieza
-        while (rr >= 0 && rr < 8 && ff >= 0 && ff < 8) {
-            const Piece *p = &b->board[rr][ff];
-            if (p->type != PIECE_NONE) {
-                if (p->color == enemy &&
-                    (p->type == PIECE_ROOK || p->type == PIECE_QUEEN)) {
-                    return 1;
-                }
-                break; // pieza bloquea el ataque
-            }
-            rr += dr;
-            ff += df;
+// Actualiza los derechos de enroque cuando se captura una torre
+static void update_castling_rights_on_capture(Board *b,
+                                              const Piece *captured,
+                                              int dr, int df)
+{
+    if (!b || !captured) return;
+    if (captured->type != PIECE_ROOK) return;
+
+    if (captured->color == COLOR_WHITE && dr == 0) { // Torre blanca capturada en fila 1
+        if (df == 0) {  // a1
+            b->white_can_castle_long = 0;
+        } else if (df == 7) {  // h1
+            b->white_can_castle_short = 0;
+        }
+    } else if (captured->color == COLOR_BLACK && dr == 7) { // Torre negra capturada en fila 8
+        if (df == 0) {  // a8
+            b->black_can_castle_long = 0;
+        } else if (df == 7) {  // h8
+            b->black_can_castle_short = 0;
         }
     }
+}
 
-    // 4) Ataques en diagonales (alfiles y damas)
-    const int dirs_diag[4][2] = {
-        { 1, 1}, { 1,-1}, {-1, 1}, {-1,-1}
-    };
-    // Recorre las 4 direcciones diagonales
-    for (int d = 0; d < 4; ++d) {
-        int dr = dirs_diag[d][0];
-        int df = dirs_diag[d][1];
-        int rr = r + dr;
-        int ff = f + df;
-        // Avanza en esa dirección hasta que se salga del tablero o encuentre una pieza
-        while (rr >= 0 && rr < 8 && ff >= 0 && ff < 8) {
-            const Piece *p = &b->board[rr][ff];
-            if (p->type != PIECE_NONE) {
-                if (p->color == enemy &&
-                    (p->type == PIECE_BISHOP || p->type == PIECE_QUEEN)) {
-                    return 1;
-                }
-                break;
-            }
-            rr += dr;
-            ff += df;
-        }
+// Derechos de enroque empaquetados en 4 bits (para MoveUndo)
+static unsigned char pack_castling(const Board *b) {
+    return (unsigned char)((b->white_can_castle_short ? 1 : 0) |
+                           (b->white_can_castle_long  ? 2 : 0) |
+                           (b->black_can_castle_short ? 4 : 0) |
+                           (b->black_can_castle_long  ? 8 : 0));
+}
+
+static void unpack_castling(Board *b, unsigned char bits) {
+    b->white_can_castle_short = (bits & 1) != 0;
+    b->white_can_castle_long  = (bits & 2) != 0;
+    b->black_can_castle_short = (bits & 4) != 0;
+    b->black_can_castle_long  = (bits & 8) != 0;
+}
+
+// Parte de la clave por en passant: solo cuenta si algún peón rival del
+// que avanzó dos casillas puede capturar al paso. El bando que captura se
+// deduce de la fila de la casilla, así la clave no depende del turno
+static uint64_t en_passant_key(const Board *b)
+{
+    if (b->en_passant_file < 0 || b->en_passant_rank < 0) return 0;
+    int ep_sq = SQ(b->en_passant_rank, b->en_passant_file);
+    Color capturer = (b->en_passant_rank == 5) ? COLOR_WHITE : COLOR_BLACK;
+    Color other = (capturer == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    if (pawn_attack_table[other - 1][ep_sq] & b->pieces[capturer - 1][PIECE_PAWN - 1]) {
+        return zobrist_en_passant[b->en_passant_file];
     }
+    return 0;
+}
 
-    // 5) Ataques del rey enemigo 
-    for (int dr = -1; dr <= 1; ++dr) {
-        for (int df = -1; df <= 1; ++df) {
-            if (dr == 0 && df == 0) continue;
-            int rr = r + dr;
-            int ff = f + df;
-            if (rr < 0 || rr >= 8 || ff < 0 || ff >= 8) continue;
-            const Piece *p = &b->board[rr][ff];
-            if (p->color == enemy && p->type == PIECE_KING) {
-                return 1;
-            }
-        }
+uint64_t board_compute_hash(const Board *b, Color side_to_move)
+{
+    uint64_t h = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        if (b->squares[sq]) h ^= ZOBRIST_PIECE(b->squares[sq], sq);
+    }
+    h ^= zobrist_castling[pack_castling(b)];
+    h ^= en_passant_key(b);
+    if (side_to_move == COLOR_BLACK) h ^= zobrist_side;
+    return h;
+}
+
+// Aplica un movimiento sin validar su legalidad y guarda en 'undo' lo
+// necesario para deshacerlo (pieza capturada, enroques y en passant previos)
+void board_make_move(Board *b, Move m, MoveUndo *undo)
+{
+    int from = MOVE_FROM(m), to = MOVE_TO(m), kind = MOVE_KIND(m);
+    unsigned char code = b->squares[from];
+    Color side = CODE_COLOR(code);
+    int cap_sq = to;
+
+    undo->move = m;
+    undo->castling = pack_castling(b);
+    undo->en_passant_sq = (b->en_passant_file >= 0 && b->en_passant_rank >= 0)
+                          ? (signed char)SQ(b->en_passant_rank, b->en_passant_file) : -1;
+    undo->hash = b->hash;
+    uint64_t old_ep_key = en_passant_key(b);
+
+    // En la captura al paso el peón capturado no está en el destino
+    if (kind == MOVE_EN_PASSANT) {
+        cap_sq = SQ(from / 8, to % 8);
     }
+    undo->captured = b->squares[cap_sq];
 
-    return 0;
+    // Derechos de enroque: se mueve el rey o una torre, o se captura una torre
+    update_castling_rights_on_move(b, side, CODE_TYPE(code), from / 8, from % 8);
+    if (undo->captured) {
+        const Piece captured = { CODE_COLOR(undo->captured), CODE_TYPE(undo->captured) };
+        update_castling_rights_on_capture(b, &captured, cap_sq / 8, cap_sq % 8);
+    }
+
+    remove_piece(b, cap_sq);
+    move_piece(b, from, to);
+
+    if (MOVE_IS_PROMOTION(m)) {
+        set_piece(b, to / 8, to % 8, side, MOVE_PROMOTION_PIECE(m));
+    } else if (kind == MOVE_CASTLE_SHORT) {
+        move_piece(b, to + 1, to - 1);   // torre h -> f
+    } else if (kind == MOVE_CASTLE_LONG) {
+        move_piece(b, to - 2, to + 1);   // torre a -> d
+    }
+
+    b->en_passant_file = -1;
+    b->en_passant_rank = -1;
+    if (kind == MOVE_DOUBLE_PUSH) {
+        b->en_passant_file = (signed char)(to % 8);
+        b->en_passant_rank = (signed char)((from / 8 + to / 8) / 2); // casilla que "saltó"
+    }
+
+    // Clave: las piezas ya se actualizaron en set_piece/remove_piece
+    b->hash ^= zobrist_castling[undo->castling] ^ zobrist_castling[pack_castling(b)];
+    b->hash ^= old_ep_key ^ en_passant_key(b);
+    b->hash ^= zobrist_side;
 }
 
-// Verifica si el rey del bando del color 'side' está en jaque
-// 1 = en jaque
-// 0 = no en jaque
-static int is_king_in_check(const Board *b, Color side)
+// Deshace un movimiento hecho con board_make_move
+void board_unmake_move(Board *b, const MoveUndo *undo)
 {
-    if (!b || side == COLOR_NONE) return 0;
+    Move m = undo->move;
+    int from = MOVE_FROM(m), to = MOVE_TO(m), kind = MOVE_KIND(m);
+    Color side = CODE_COLOR(b->squares[to]);
 
-    int king_r = -1, king_f = -1;
+    if (kind == MOVE_CASTLE_SHORT) {
+        move_piece(b, to - 1, to + 1);
+    } else if (kind == MOVE_CASTLE_LONG) {
+        move_piece(b, to + 1, to - 2);
+    }
 
-    // Buscar al rey de 'side' en el tablero
-    for (int r = 0; r < 8; ++r) {
-        for (int f = 0; f < 8; ++f) {
-            const Piece *p = &b->board[r][f];
-            if (p->color == side && p->type == PIECE_KING) {
-                king_r = r;
-                king_f = f;
-                break;
-            }
-        }
-        if (king_r != -1) break;
+    if (MOVE_IS_PROMOTION(m)) {
+        remove_piece(b, to);
+        set_piece(b, from / 8, from % 8, side, PIECE_PAWN);
+    } else {
+        move_piece(b, to, from);
     }
 
-    if (king_r == -1) {
-        // Posición ilegal (no hay rey), pero por ahora devolvemos "no en jaque"
-        return 0;
+    if (undo->captured) {
+        int cap_sq = (kind == MOVE_EN_PASSANT) ? SQ(from / 8, to % 8) : to;
+        set_piece(b, cap_sq / 8, cap_sq % 8,
+                  CODE_COLOR(undo->captured), CODE_TYPE(undo->captured));
     }
 
-    Color enemy = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
-    return is_square_attacked(b, king_r, king_f, enemy);
+    unpack_castling(b, undo->castling);
+    b->en_passant_file = (undo->en_passant_sq >= 0) ? (signed char)(undo->en_passant_sq % 8) : -1;
+    b->en_passant_rank = (undo->en_passant_sq >= 0) ? (signed char)(undo->en_passant_sq / 8) : -1;
+    b->hash = undo->hash;
+}
+
+// Prueba el movimiento con make/unmake: 1 si deja en jaque al rey de 'side'.
+// El tablero queda igual que estaba.
+static int move_leaves_king_in_check(Board *b, Move m, Color side)
+{
+    MoveUndo undo;
+    board_make_move(b, m, &undo);
+    int in_check = is_king_in_check(b, side);
+    board_unmake_move(b, &undo);
+    return in_check;
 }
 
 // Convierte el char de MoveAST.piece a enum PieceType
@@ -291,13 +509,13 @@ static int can_knight_move(const Board *b,
         return 0;
     }
 
-    const Piece *dest = &b->board[dr][df]; // Va a la casilla de destino
+    const Piece dest = piece_at(b, dr, df); // Va a la casilla de destino
 
     if (is_capture) {       // Valida captura
-        if (dest->type == PIECE_NONE) return 0;
-        if (dest->color == side_to_move) return 0; // No puede capturar pieza propia
+        if (dest.type == PIECE_NONE) return 0;
+        if (dest.color == side_to_move) return 0; // No puede capturar pieza propia
     } else {
-        if (dest->type != PIECE_NONE) return 0; // No indica captura pero hay una pieza ahí
+        if (dest.type != PIECE_NONE) return 0; // No indica captura pero hay una pieza ahí
     }
 
     return 1;
@@ -307,7 +525,7 @@ static int can_knight_move(const Board *b,
 // Busca la casilla origen (sr,sf) de un movimiento de caballo.
 // 0 = valido
 // -1 = error (mensaje en error_msg)
-static int find_knight_source(const Board *b,
+static int find_knight_source(Board *b,
                               const MoveAST *mv,    // movimiento a aplicar
                               Color side_to_move,
                               int *out_sr,      // source rank
@@ -339,42 +557,30 @@ static int find_knight_source(const Board *b,
     int found = 0;
     int best_sr = -1, best_sf = -1;
 
-    /* revisar todas las casillas del tablero */
-    for (int r = 0; r < 8; ++r) {
-        for (int f = 0; f < 8; ++f) {
-            const Piece *p = &b->board[r][f];
-
-            if (p->type != PIECE_KNIGHT) continue;
-            if (p->color != side_to_move) continue;
-
-            /* aplicar filtros de desambiguación, si existen */
-            if (src_file_filter != -1 && f != src_file_filter) continue; // filtra por columna
-            if (src_rank_filter != -1 && r != src_rank_filter) continue; // filtra por fila
-
-            /* ¿puede este caballo ir al destino? */
-            if (!can_knight_move(b, r, f, dr, df, mv->is_capture, side_to_move)) {
-                continue;
-            }
-
-            // Simular el movimiento y verificar si deja al rey en jaque
-            Board tmp = *b;
+    /* revisar solo las casillas con caballos propios */
+    Bitboard candidates = b->pieces[side_to_move - 1][PIECE_KNIGHT - 1];
+    while (candidates) {
+        int s = bb_pop_lsb(&candidates);
+        int r = s / 8, f = s % 8;
 
-            Piece moving = tmp.board[r][f];
-            Piece captured = tmp.board[dr][df];  // puede ser NONE
+        /* aplicar filtros de desambiguación, si existen */
+        if (src_file_filter != -1 && f != src_file_filter) continue; // filtra por columna
+        if (src_rank_filter != -1 && r != src_rank_filter) continue; // filtra por fila
 
-            tmp.board[r][f].type  = PIECE_NONE;
-            tmp.board[r][f].color = COLOR_NONE;
-            tmp.board[dr][df]     = moving;
-
-            if (is_king_in_check(&tmp, side_to_move)) {
-                continue;
-            }
+        /* ¿puede este caballo ir al destino? */
+        if (!can_knight_move(b, r, f, dr, df, mv->is_capture, side_to_move)) {
+            continue;
+        }
 
-            /* candidato válido encontrado */
-            found++;
-            best_sr = r;
-            best_sf = f;
+        // Simular con make/unmake y verificar si deja al rey en jaque
+        if (move_leaves_king_in_check(b, MOVE_MAKE(s, SQ(dr, df), MOVE_NORMAL), side_to_move)) {
+            continue;
         }
+
+        /* candidato válido encontrado */
+        found++;
+        best_sr = r;
+        best_sf = f;
     }
 
     if (found == 0) {
@@ -422,7 +628,7 @@ static int can_pawn_move(const Board *b,
     int d_rank = dr - sr;
     int d_file = df - sf;
 
-    const Piece *dest = &b->board[dr][df];
+    const Piece dest = piece_at(b, dr, df);
 
     // Caso de captura
     if (is_capture) {
@@ -431,11 +637,9 @@ static int can_pawn_move(const Board *b,
             return 0;
         }
 
-        const Piece *dest = &b->board[dr][df];
-
-        if (dest->type != PIECE_NONE) {
+        if (dest.type != PIECE_NONE) {
             // Captura normal: debe haber pieza enemiga en destino
-            if (dest->color == side_to_move) { // no puedes capturar una pieza propia
+            if (dest.color == side_to_move) { // no puedes capturar una pieza propia
                 return 0;
             }
         } else {
@@ -446,9 +650,9 @@ static int can_pawn_move(const Board *b,
                 if (pawn_rank < 0 || pawn_rank > 7) {
                     return 0;
                 }
-                const Piece *ep_pawn = &b->board[pawn_rank][df];
-                if (ep_pawn->type != PIECE_PAWN ||
-                    ep_pawn->color == side_to_move) {
+                const Piece ep_pawn = piece_at(b, pawn_rank, df);
+                if (ep_pawn.type != PIECE_PAWN ||
+                    ep_pawn.color == side_to_move) {
                     return 0;
                 }
                 // Es una captura al paso legal
@@ -463,18 +667,16 @@ static int can_pawn_move(const Board *b,
             return 0;
         }
         if (d_rank == dir) { // casilla de adelante debe estar vacía
-            if (dest->type != PIECE_NONE) {
+            if (dest.type != PIECE_NONE) {
                 return 0;
             }
         }
         else if (d_rank == 2 * dir && sr == start_rank) { // valida doble paso
             int intermediate_rank = sr + dir;
-            const Piece *intermediate = &b->board[intermediate_rank][sf];
-
-            if (intermediate->type != PIECE_NONE) { // valida que no haya pieza en el camino
+            if (b->occupied_all & SQ_BIT(SQ(intermediate_rank, sf))) { // valida que no haya pieza en el camino
                 return 0;
             }
-            if (dest->type != PIECE_NONE) { // destino debe estar vacío
+            if (dest.type != PIECE_NONE) { // destino debe estar vacío
                 return 0;
             }
         }
@@ -502,7 +704,7 @@ static int can_pawn_move(const Board *b,
 // Busca la casilla origen (sr,sf) de un movimiento de peón.
 // 0 = válido
 // -1 = error
-static int find_pawn_source(const Board *b,
+static int find_pawn_source(Board *b,
                             const MoveAST *mv,
                             Color side_to_move,
                             int *out_sr,
@@ -530,89 +732,65 @@ static int find_pawn_source(const Board *b,
     int best_sr = -1, best_sf = -1; // mejores candidatos
 
     // Recorremos todos los peones del jugador
-    for (int r = 0; r < 8; ++r) {
-        for (int f = 0; f < 8; ++f) {
-
-            const Piece *p = &b->board[r][f];
-            if (p->type != PIECE_PAWN || p->color != side_to_move)
-                continue;
-
-            // Filtro por desambiguación 
-            if (src_file_filter != -1 && f != src_file_filter)
-                continue;
-            if (src_rank_filter != -1 && r != src_rank_filter)
-                continue;
-
-            // CAPTURA AL PASO
-            if (mv->is_capture &&
-                b->en_passant_file == df &&
-                b->en_passant_rank == dr)
-            {
-                int dir = (side_to_move == COLOR_WHITE) ? 1 : -1;
-
-                // Un peón que está en columna adyacente y en la fila correcta
-                if (r == dr - dir && (f == df + 1 || f == df - 1)) {
-
-                    // Confirmar que detrás del destino hay peón enemigo
-                    int pawn_rank = dr - dir;
-                    const Piece *ep = &b->board[pawn_rank][df];
-
-                    if (ep->type == PIECE_PAWN && ep->color != side_to_move) {
-
-                        // 🔍 Simular la captura al paso para ver si deja al rey en jaque
-                        Board tmp = *b;
-                        
-                        Piece moving = tmp.board[r][f];
-
-                        tmp.board[r][f].type  = PIECE_NONE;
-                        tmp.board[r][f].color = COLOR_NONE;
-
-                        tmp.board[pawn_rank][df].type  = PIECE_NONE;
-                        tmp.board[pawn_rank][df].color = COLOR_NONE;
-
-                        tmp.board[dr][df] = moving;
-
-                        // Verificar si el rey queda en jaque
-                        if (is_king_in_check(&tmp, side_to_move)) {
-                            goto skip_en_passant_candidate;
-                        }
+    Bitboard candidates = b->pieces[side_to_move - 1][PIECE_PAWN - 1];
+    while (candidates) {
+        int s = bb_pop_lsb(&candidates);
+        int r = s / 8, f = s % 8;
+
+        // Filtro por desambiguación 
+        if (src_file_filter != -1 && f != src_file_filter)
+            continue;
+        if (src_rank_filter != -1 && r != src_rank_filter)
+            continue;
+
+        // CAPTURA AL PASO
+        if (mv->is_capture &&
+            b->en_passant_file == df &&
+            b->en_passant_rank == dr)
+        {
+            int dir = (side_to_move == COLOR_WHITE) ? 1 : -1;
+
+            // Un peón que está en columna adyacente y en la fila correcta
+            if (r == dr - dir && (f == df + 1 || f == df - 1)) {
+
+                // Confirmar que detrás del destino hay peón enemigo
+                int pawn_rank = dr - dir;
+                const Piece ep = piece_at(b, pawn_rank, df);
+
+                if (ep.type == PIECE_PAWN && ep.color != side_to_move) {
+
+                    // 🔍 Simular la captura al paso para ver si deja al rey en jaque
+                    if (move_leaves_king_in_check(b, MOVE_MAKE(s, SQ(dr, df), MOVE_EN_PASSANT),
+                                                  side_to_move)) {
+                        goto skip_en_passant_candidate;
+                    }
 
-                        
-                        *out_sr = r;
-                        *out_sf = f;
-                        return 0;
+                    
+                    *out_sr = r;
+                    *out_sf = f;
+                    return 0;
 
-                    skip_en_passant_candidate:
-                        ;
-                    }
+                skip_en_passant_candidate:
+                    ;
                 }
             }
+        }
 
-            // MOVIMIENTOS NORMALES O CAPTURA NORMAL 
-            if (!can_pawn_move(b, r, f, dr, df,
-                               mv->is_capture,
-                               side_to_move,
-                               is_promotion_requested))
-                continue;
-
-            // Simular movimiento de peón
-            Board tmp = *b;
-            Piece moving  = tmp.board[r][f];
-            Piece captured = tmp.board[dr][df]; // o NONE
-
-            tmp.board[r][f].type  = PIECE_NONE;
-            tmp.board[r][f].color = COLOR_NONE;
-            tmp.board[dr][df]     = moving;
-
-            // Validar si la movida deja al rey en jaque
-            if (is_king_in_check(&tmp, side_to_move)) {
-                continue;
-            }
+        // MOVIMIENTOS NORMALES O CAPTURA NORMAL 
+        if (!can_pawn_move(b, r, f, dr, df,
+                           mv->is_capture,
+                           side_to_move,
+                           is_promotion_requested))
+            continue;
 
-            found++;
-            best_sr = r;
-            best_sf = f;
+        // Simular con make/unmake y verificar si deja al rey en jaque
+        if (move_leaves_king_in_check(b, MOVE_MAKE(s, SQ(dr, df), MOVE_NORMAL), side_to_move)) {
+            continue;
         }
+
+        found++;
+        best_sr = r;
+        best_sf = f;
     }
 
     if (found == 0) {
@@ -650,7 +828,7 @@ static int path_is_clear(const Board *b, int sr, int sf, int dr, int df)
     int f = sf + step_f;
 
     while (r != dr || f != df) {
-        if (b->board[r][f].type != PIECE_NONE)
+        if (b->occupied_all & SQ_BIT(SQ(r, f)))
             return 0;  // hay algo en el camino
 
         r += step_r;
@@ -668,7 +846,7 @@ static int can_bishop_move(const Board *b,
                            int is_capture,
                            Color side)
 {
-    const Piece *dest = &b->board[dr][df]; // pieza en destino
+    const Piece dest = piece_at(b, dr, df); // pieza en destino
 
     int d_rank = dr - sr;
     int d_file = df - sf;
@@ -684,10 +862,10 @@ static int can_bishop_move(const Board *b,
 
     // manejar captura / no captura
     if (is_capture) {
-        if (dest->type == PIECE_NONE) return 0;
-        if (dest->color == side) return 0;
+        if (dest.type == PIECE_NONE) return 0;
+        if (dest.color == side) return 0;
     } else {
-        if (dest->type != PIECE_NONE) return 0;
+        if (dest.type != PIECE_NONE) return 0;
     }
     return 1;
 }
@@ -695,7 +873,7 @@ static int can_bishop_move(const Board *b,
 // Busca la casilla origen (sr,sf) de un movimiento de alfil.
 // 0 = válido
 // -1 = error
-static int find_bishop_source(const Board *b,
+static int find_bishop_source(Board *b,
                               const MoveAST *mv,
                               Color side,
                               int *out_sr,
@@ -713,36 +891,25 @@ static int find_bishop_source(const Board *b,
     int found = 0;
 
     // revisar todas las casillas del tablero
-    for (int r = 0; r < 8; r++) {
-        for (int f = 0; f < 8; f++) {
-            const Piece *p = &b->board[r][f];
-
-            if (p->type != PIECE_BISHOP || p->color != side) continue;
-
-            if (src_file_filter != -1 && f != src_file_filter) continue;
-            if (src_rank_filter != -1 && r != src_rank_filter) continue;
-
-            if (!can_bishop_move(b, r, f, dr, df, mv->is_capture, side))
-                continue;
+    Bitboard candidates = b->pieces[side - 1][PIECE_BISHOP - 1];
+    while (candidates) {
+        int s = bb_pop_lsb(&candidates);
+        int r = s / 8, f = s % 8;
 
-            // Simular movimiento
-            Board tmp = *b;
-            Piece moving  = tmp.board[r][f];
-            Piece captured = tmp.board[dr][df];
+        if (src_file_filter != -1 && f != src_file_filter) continue;
+        if (src_rank_filter != -1 && r != src_rank_filter) continue;
 
-            tmp.board[r][f].type  = PIECE_NONE;
-            tmp.board[r][f].color = COLOR_NONE;
-            tmp.board[dr][df]     = moving;
+        if (!can_bishop_move(b, r, f, dr, df, mv->is_capture, side))
+            continue;
 
-            // Validar si la movida deja al rey en jaque
-            if (is_king_in_check(&tmp, side)) {
-                continue;
-            }
-
-            found++;
-            *out_sr = r;
-            *out_sf = f;
+        // Simular con make/unmake y verificar si deja al rey en jaque
+        if (move_leaves_king_in_check(b, MOVE_MAKE(s, SQ(dr, df), MOVE_NORMAL), side)) {
+            continue;
         }
+
+        found++;
+        *out_sr = r;
+        *out_sf = f;
     }
 
     if (found == 0) {
@@ -765,7 +932,7 @@ static int can_rook_move(const Board *b,
                          int is_capture,
                          Color side)
 {
-    const Piece *dest = &b->board[dr][df];
+    const Piece dest = piece_at(b, dr, df);
 
     // debe ser vertical u horizontal
     if (!(sr == dr || sf == df)) return 0;
@@ -775,10 +942,10 @@ static int can_rook_move(const Board *b,
 
     // captura / no captura
     if (is_capture) {
-        if (dest->type == PIECE_NONE) return 0;
-        if (dest->color == side) return 0;
+        if (dest.type == PIECE_NONE) return 0;
+        if (dest.color == side) return 0;
     } else {
-        if (dest->type != PIECE_NONE) return 0;
+        if (dest.type != PIECE_NONE) return 0;
     }
     return 1;
 }
@@ -786,7 +953,7 @@ static int can_rook_move(const Board *b,
 // Busca la casilla origen (sr,sf) de un movimiento de torre.
 // 0 = válido
 // -1 = error
-static int find_rook_source(const Board *b,
+static int find_rook_source(Board *b,
                             const MoveAST *mv,
                             Color side,
                             int *out_sr,
@@ -802,35 +969,25 @@ static int find_rook_source(const Board *b,
 
     int found = 0;
 
-    for (int r = 0; r < 8; r++) {
-        for (int f = 0; f < 8; f++) {
-            const Piece *p = &b->board[r][f];
-
-            if (p->type != PIECE_ROOK || p->color != side) continue;
-
-            if (src_file_filter != -1 && f != src_file_filter) continue;
-            if (src_rank_filter != -1 && r != src_rank_filter) continue;
-
-            if (!can_rook_move(b, r, f, dr, df, mv->is_capture, side))
-                continue;
-
-            Board tmp = *b;
-            Piece moving  = tmp.board[r][f];
-            Piece captured = tmp.board[dr][df];
+    Bitboard candidates = b->pieces[side - 1][PIECE_ROOK - 1];
+    while (candidates) {
+        int s = bb_pop_lsb(&candidates);
+        int r = s / 8, f = s % 8;
 
-            tmp.board[r][f].type  = PIECE_NONE;
-            tmp.board[r][f].color = COLOR_NONE;
-            tmp.board[dr][df]     = moving;
+        if (src_file_filter != -1 && f != src_file_filter) continue;
+        if (src_rank_filter != -1 && r != src_rank_filter) continue;
 
-            // Validar si la movida deja al rey en jaque
-            if (is_king_in_check(&tmp, side)) {
-                continue;
-            }
+        if (!can_rook_move(b, r, f, dr, df, mv->is_capture, side))
+            continue;
 
-            found++;
-            *out_sr = r;
-            *out_sf = f;
+        // Simular con make/unmake y verificar si deja al rey en jaque
+        if (move_leaves_king_in_check(b, MOVE_MAKE(s, SQ(dr, df), MOVE_NORMAL), side)) {
+            continue;
         }
+
+        found++;
+        *out_sr = r;
+        *out_sf = f;
     }
 
     if (found == 0) {
@@ -861,13 +1018,13 @@ static int can_queen_move(const Board *b,
 
     if (!path_is_clear(b, sr, sf, dr, df)) return 0;
 
-    const Piece *dest = &b->board[dr][df];
+    const Piece dest = piece_at(b, dr, df);
 
     if (is_capture) {
-        if (dest->type == PIECE_NONE) return 0;
-        if (dest->color == side) return 0;
+        if (dest.type == PIECE_NONE) return 0;
+        if (dest.color == side) return 0;
     } else {
-        if (dest->type != PIECE_NONE) return 0;
+        if (dest.type != PIECE_NONE) return 0;
     }
     return 1;
 }
@@ -875,7 +1032,7 @@ static int can_queen_move(const Board *b,
 // Busca la casilla origen (sr,sf) de un movimiento de dama.
 // 0 = válido
 // -1 = error
-static int find_queen_source(const Board *b,
+static int find_queen_source(Board *b,
                              const MoveAST *mv,
                              Color side,
                              int *out_sr,
@@ -891,36 +1048,25 @@ static int find_queen_source(const Board *b,
 
     int found = 0;
 
-    for (int r = 0; r < 8; r++) {
-        for (int f = 0; f < 8; f++) {
-            const Piece *p = &b->board[r][f];
-
-            if (p->type != PIECE_QUEEN || p->color != side) continue;
-
-            if (src_file_filter != -1 && f != src_file_filter) continue;
-            if (src_rank_filter != -1 && r != src_rank_filter) continue;
-
-            if (!can_queen_move(b, r, f, dr, df, mv->is_capture, side))
-                continue;
-
-            // Simular movimiento
-            Board tmp = *b;
-            Piece moving  = tmp.board[r][f];
-            Piece captured = tmp.board[dr][df];
+    Bitboard candidates = b->pieces[side - 1][PIECE_QUEEN - 1];
+    while (candidates) {
+        int s = bb_pop_lsb(&candidates);
+        int r = s / 8, f = s % 8;
 
-            tmp.board[r][f].type  = PIECE_NONE;
-            tmp.board[r][f].color = COLOR_NONE;
-            tmp.board[dr][df]     = moving;
+        if (src_file_filter != -1 && f != src_file_filter) continue;
+        if (src_rank_filter != -1 && r != src_rank_filter) continue;
 
-            // Validar si la movida deja al rey en jaque
-            if (is_king_in_check(&tmp, side)) {
-                continue;
-            }
+        if (!can_queen_move(b, r, f, dr, df, mv->is_capture, side))
+            continue;
 
-            found++;
-            *out_sr = r;
-            *out_sf = f;
+        // Simular con make/unmake y verificar si deja al rey en jaque
+        if (move_leaves_king_in_check(b, MOVE_MAKE(s, SQ(dr, df), MOVE_NORMAL), side)) {
+            continue;
         }
+
+        found++;
+        *out_sr = r;
+        *out_sf = f;
     }
 
     if (found == 0) {
@@ -953,193 +1099,276 @@ static int can_king_move(const Board *b,
         return 0;
     }
 
-    const Piece *dest = &b->board[dr][df];
+    const Piece dest = piece_at(b, dr, df);
 
     if (is_capture) {
-        if (dest->type == PIECE_NONE) return 0;
-        if (dest->color == side) return 0;
+        if (dest.type == PIECE_NONE) return 0;
+        if (dest.color == side) return 0;
     } else {
-        if (dest->type != PIECE_NONE) return 0;
+        if (dest.type != PIECE_NONE) return 0;
     }
 
     return 1;
 }
 
-static int has_any_legal_move(const Board *b, Color side)
+// Todas las piezas (de ambos colores) que atacan sq con la ocupación 'occ'
+static Bitboard attackers_to(const Board *b, int sq, Bitboard occ)
 {
-    if (!b || side == COLOR_NONE) return 0;
+    const Bitboard *w = b->pieces[COLOR_WHITE - 1];
+    const Bitboard *k = b->pieces[COLOR_BLACK - 1];
+
+    Bitboard rooks   = w[PIECE_ROOK - 1]   | k[PIECE_ROOK - 1]   |
+                       w[PIECE_QUEEN - 1]  | k[PIECE_QUEEN - 1];
+    Bitboard bishops = w[PIECE_BISHOP - 1] | k[PIECE_BISHOP - 1] |
+                       w[PIECE_QUEEN - 1]  | k[PIECE_QUEEN - 1];
+
+    return (pawn_attacks(COLOR_BLACK, sq) & w[PIECE_PAWN - 1])
+         | (pawn_attacks(COLOR_WHITE, sq) & k[PIECE_PAWN - 1])
+         | (knight_attacks(sq) & (w[PIECE_KNIGHT - 1] | k[PIECE_KNIGHT - 1]))
+         | (king_attacks(sq)   & (w[PIECE_KING - 1]   | k[PIECE_KING - 1]))
+         | (rook_attacks(sq, occ)   & rooks)
+         | (bishop_attacks(sq, occ) & bishops);
+}
+
+// Añade un movimiento; si se llegó al límite pedido, termina la generación
+#define PUSH_MOVE(list, from, to, kind, limit)                     \
+    do {                                                           \
+        (list)->moves[(list)->count++] = MOVE_MAKE(from, to, kind); \
+        if ((list)->count >= (limit)) return (list)->count;        \
+    } while (0)
+
+// Genera las jugadas legales de 'side' por etapas: rey, piezas, peones y
+// enroques. Las piezas clavadas solo se mueven sobre la línea de su clavada
+// y, si hay jaque simple, solo valen las jugadas que capturan o tapan
+// (máscara de evasión). Con jaque doble solo se genera el rey.
+// Se detiene al alcanzar 'limit' jugadas. Devuelve la cantidad generada.
+static int generate_legal_moves(const Board *b, Color side, MoveList *list, int limit)
+{
+    list->count = 0;
+    if (!b || side == COLOR_NONE || limit <= 0) return 0;
 
     Color enemy = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    const Bitboard *mine   = b->pieces[side - 1];
+    const Bitboard *theirs = b->pieces[enemy - 1];
+    Bitboard own = b->occupied[side - 1];
+    Bitboard opp = b->occupied[enemy - 1];
+    Bitboard occ = b->occupied_all;
+
+    Bitboard evasion = ~(Bitboard)0;   // destinos permitidos para piezas que no son el rey
+    Bitboard pinned = 0;               // piezas propias clavadas contra el rey
+    Bitboard checkers = 0;
+    int ksq = -1;
+
+    if (mine[PIECE_KING - 1]) {
+        ksq = bb_lsb(mine[PIECE_KING - 1]);
+        checkers = attackers_to(b, ksq, occ) & opp;
+
+        // 1) Jugadas de rey: el destino no debe quedar atacado. El rey se
+        //    quita de la ocupación para ver los rayos que lo atraviesan.
+        Bitboard occ_no_king = occ ^ SQ_BIT(ksq);
+        Bitboard targets = king_attacks(ksq) & ~own;
+        while (targets) {
+            int to = bb_pop_lsb(&targets);
+            if (!(attackers_to(b, to, occ_no_king) & opp))
+                PUSH_MOVE(list, ksq, to, MOVE_NORMAL, limit);
+        }
 
-    for (int sr = 0; sr < 8; ++sr) {
-        for (int sf = 0; sf < 8; ++sf) {
+        // Jaque doble: solo puede moverse el rey
+        if (checkers & (checkers - 1)) return list->count;
 
-            const Piece *p = &b->board[sr][sf];
-            if (p->color != side || p->type == PIECE_NONE)
-                continue;
+        // Jaque simple: capturar a la pieza que da jaque o interponerse
+        if (checkers) {
+            evasion = checkers | between(ksq, bb_lsb(checkers));
+        }
 
-            PieceType pt = p->type;
+        // Piezas clavadas: una única pieza propia entre el rey y un
+        // deslizador enemigo alineado con él
+        Bitboard snipers =
+            (rook_attacks(ksq, 0)   & (theirs[PIECE_ROOK - 1]   | theirs[PIECE_QUEEN - 1])) |
+            (bishop_attacks(ksq, 0) & (theirs[PIECE_BISHOP - 1] | theirs[PIECE_QUEEN - 1]));
+        while (snipers) {
+            int s = bb_pop_lsb(&snipers);
+            Bitboard blockers = between(ksq, s) & occ;
+            if (blockers && !(blockers & (blockers - 1)) && (blockers & own)) {
+                pinned |= blockers;
+            }
+        }
+    }
 
-            // Recorremos todas las casillas destino posibles
-            for (int dr = 0; dr < 8; ++dr) {
-                for (int df = 0; df < 8; ++df) {
+    // 2) Caballos, alfiles, torres y damas
+    for (PieceType pt = PIECE_KNIGHT; pt <= PIECE_QUEEN; ++pt) {
+        Bitboard pieces = mine[pt - 1];
+        if (pt == PIECE_KNIGHT) pieces &= ~pinned; // un caballo clavado nunca puede moverse
 
-                    // No validamos quedarse en la misma casilla
-                    if (dr == sr && df == sf) continue;
+        while (pieces) {
+            int from = bb_pop_lsb(&pieces);
+            Bitboard targets;
+            switch (pt) {
+                case PIECE_KNIGHT: targets = knight_attacks(from);      break;
+                case PIECE_BISHOP: targets = bishop_attacks(from, occ); break;
+                case PIECE_ROOK:   targets = rook_attacks(from, occ);   break;
+                default:           targets = queen_attacks(from, occ);  break;
+            }
+            targets &= ~own & evasion;
+            if (pinned & SQ_BIT(from)) targets &= line_through(ksq, from);
 
-                    const Piece *dest = &b->board[dr][df];
+            while (targets) {
+                int to = bb_pop_lsb(&targets);
+                PUSH_MOVE(list, from, to, MOVE_NORMAL, limit);
+            }
+        }
+    }
 
-                    // Omitir movimientos que capturan pieza propia
-                    if (dest->type != PIECE_NONE && dest->color == side)
-                        continue;
+    // 3) Peones: avances, doble paso, capturas, promociones y captura al paso
+    int dir        = (side == COLOR_WHITE) ? 8 : -8;
+    int start_rank = (side == COLOR_WHITE) ? 1 : 6;
+    int last_rank  = (side == COLOR_WHITE) ? 7 : 0;
+    int ep_sq = (b->en_passant_file >= 0 && b->en_passant_rank >= 0)
+                ? SQ(b->en_passant_rank, b->en_passant_file) : -1;
+
+    Bitboard pawns = mine[PIECE_PAWN - 1];
+    while (pawns) {
+        int from = bb_pop_lsb(&pawns);
+        int to = from + dir;
+        if (to < 0 || to > 63) continue;
+
+        Bitboard allowed = evasion;
+        if (pinned & SQ_BIT(from)) allowed &= line_through(ksq, from);
+
+        // Avance simple y doble
+        Bitboard targets = 0;
+        if (!(occ & SQ_BIT(to))) {
+            targets |= SQ_BIT(to) & allowed;
+            int to2 = to + dir;
+            if (from / 8 == start_rank && !(occ & SQ_BIT(to2)) && (allowed & SQ_BIT(to2)))
+                PUSH_MOVE(list, from, to2, MOVE_DOUBLE_PUSH, limit);
+        }
 
-                    int is_capture = (dest->type != PIECE_NONE);
+        // Capturas normales
+        targets |= pawn_attacks(side, from) & opp & allowed;
 
-                    // Lógica especial para peones: en passant
-                    int is_en_passant_capture = 0;
+        while (targets) {
+            int t = bb_pop_lsb(&targets);
+            if (t / 8 == last_rank) {
+                PUSH_MOVE(list, from, t, MOVE_PROMO_QUEEN, limit);
+                PUSH_MOVE(list, from, t, MOVE_PROMO_ROOK, limit);
+                PUSH_MOVE(list, from, t, MOVE_PROMO_BISHOP, limit);
+                PUSH_MOVE(list, from, t, MOVE_PROMO_KNIGHT, limit);
+            } else {
+                PUSH_MOVE(list, from, t, MOVE_NORMAL, limit);
+            }
+        }
 
-                    if (pt == PIECE_PAWN && dest->type == PIECE_NONE) {
-                        if (b->en_passant_file == df && b->en_passant_rank == dr) {
-                            int pawn_rank = (side == COLOR_WHITE) ? dr - 1 : dr + 1;
-                            if (pawn_rank >= 0 && pawn_rank < 8) {
-                                const Piece *ep = &b->board[pawn_rank][df];
-                                if (ep->type == PIECE_PAWN && ep->color == enemy) {
-                                    is_capture = 1;
-                                    is_en_passant_capture = 1;
-                                }
-                            }
-                        }
-                    }
+        // Captura al paso: se comprueba directamente sobre la ocupación
+        // resultante, porque quita dos piezas de la misma fila a la vez
+        if (ep_sq >= 0 && (pawn_attacks(side, from) & SQ_BIT(ep_sq)) &&
+            !(occ & SQ_BIT(ep_sq))) {
+            int cap = ep_sq - dir;
+            if (theirs[PIECE_PAWN - 1] & SQ_BIT(cap)) {
+                int legal = 1;
+                if (ksq >= 0) {
+                    Bitboard occ2 = (occ ^ SQ_BIT(from) ^ SQ_BIT(cap)) | SQ_BIT(ep_sq);
+                    Bitboard att =
+                        (rook_attacks(ksq, occ2)   & (theirs[PIECE_ROOK - 1]   | theirs[PIECE_QUEEN - 1])) |
+                        (bishop_attacks(ksq, occ2) & (theirs[PIECE_BISHOP - 1] | theirs[PIECE_QUEEN - 1])) |
+                        (knight_attacks(ksq)       & theirs[PIECE_KNIGHT - 1]) |
+                        (pawn_attacks(side, ksq)   & theirs[PIECE_PAWN - 1] & ~SQ_BIT(cap));
+                    legal = (att == 0);
+                }
+                if (legal) PUSH_MOVE(list, from, ep_sq, MOVE_EN_PASSANT, limit);
+            }
+        }
+    }
 
-                    int is_promotion_requested = 0;
-                    if (pt == PIECE_PAWN) {
-                        int last_rank = (side == COLOR_WHITE) ? 7 : 0;
-                        if (dr == last_rank) {
-                            is_promotion_requested = 1;
-                        }
-                    }
+    // 4) Enroques: rey y torre en su casilla inicial, sin jaque, casillas
+    //    intermedias vacías y casillas de paso del rey no atacadas
+    int base = (side == COLOR_WHITE) ? 0 : 56;
+    if (!checkers && ksq == base + 4) {
+        int can_short = (side == COLOR_WHITE) ? b->white_can_castle_short : b->black_can_castle_short;
+        int can_long  = (side == COLOR_WHITE) ? b->white_can_castle_long  : b->black_can_castle_long;
+        Bitboard rooks = mine[PIECE_ROOK - 1];
 
-                    // Comprobar movimiento geométricamente válido
-                    int ok = 0;
-                    switch (pt) {
-                        case PIECE_PAWN:
-                            ok = can_pawn_move(b, sr, sf, dr, df,
-                                               is_capture,
-                                               side,
-                                               is_promotion_requested);
-                            break;
-                        case PIECE_KNIGHT:
-                            ok = can_knight_move(b, sr, sf, dr, df, is_capture, side);
-                            break;
-                        case PIECE_BISHOP:
-                            ok = can_bishop_move(b, sr, sf, dr, df, is_capture, side);
-                            break;
-                        case PIECE_ROOK:
-                            ok = can_rook_move(b, sr, sf, dr, df, is_capture, side);
-                            break;
-                        case PIECE_QUEEN:
-                            ok = can_queen_move(b, sr, sf, dr, df, is_capture, side);
-                            break;
-                        case PIECE_KING:
-                            ok = can_king_move(b, sr, sf, dr, df, is_capture, side);
-                            break;
-                        default:
-                            ok = 0;
-                            break;
-                    }
+        if (can_short && (rooks & SQ_BIT(base + 7)) &&
+            !(occ & (SQ_BIT(base + 5) | SQ_BIT(base + 6))) &&
+            !(attackers_to(b, base + 5, occ) & opp) &&
+            !(attackers_to(b, base + 6, occ) & opp))
+            PUSH_MOVE(list, ksq, base + 6, MOVE_CASTLE_SHORT, limit);
 
-                    if (!ok) continue;
+        if (can_long && (rooks & SQ_BIT(base)) &&
+            !(occ & (SQ_BIT(base + 1) | SQ_BIT(base + 2) | SQ_BIT(base + 3))) &&
+            !(attackers_to(b, base + 3, occ) & opp) &&
+            !(attackers_to(b, base + 2, occ) & opp))
+            PUSH_MOVE(list, ksq, base + 2, MOVE_CASTLE_LONG, limit);
+    }
 
-                    // Simular el movimiento en un tablero temporal
-                    Board tmp = *b;
-                    Piece moving = tmp.board[sr][sf];
+    return list->count;
+}
 
-                    tmp.board[sr][sf].type  = PIECE_NONE;
-                    tmp.board[sr][sf].color = COLOR_NONE;
+#undef PUSH_MOVE
 
-                    // Captura al paso: eliminar el peón enemigo en la casilla correcta
-                    if (pt == PIECE_PAWN && is_en_passant_capture) {
-                        int pawn_rank = (side == COLOR_WHITE) ? dr - 1 : dr + 1;
-                        tmp.board[pawn_rank][df].type  = PIECE_NONE;
-                        tmp.board[pawn_rank][df].color = COLOR_NONE;
-                    }
+int board_generate_legal_moves(const Board *b, Color side, MoveList *list)
+{
+    if (!list) return 0;
+    return generate_legal_moves(b, side, list, (int)(sizeof(list->moves) / sizeof(list->moves[0])));
+}
 
-                    // Promoción: para efectos de jaque/ahogado, basta con promover a dama
-                    if (pt == PIECE_PAWN && is_promotion_requested) {
-                        moving.type = PIECE_QUEEN;
-                    }
+// 1 si 'side' tiene al menos una jugada legal: la generación se detiene
+// en la primera que encuentra
+static int has_any_legal_move(const Board *b, Color side)
+{
+    MoveList list;
+    return generate_legal_moves(b, side, &list, 1) > 0;
+}
 
-                    tmp.board[dr][df] = moving;
+// Sal por turno para la clave de la caché de estados: independiente de la
+// clave de turno de Zobrist, así una posición creada con el turno "incorrecto"
+// (board_from_grid con negras) solo produce fallos, nunca datos de otra
+static const uint64_t status_key_salt[2] = {
+    0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL
+};
 
-                    // Si después de este movimiento el rey de 'side' NO está en jaque,
-                    // entonces existe al menos una jugada legal.
-                    if (!is_king_in_check(&tmp, side)) {
-                        return 1;
-                    }
-                }
-            }
-        }
-    }
-
-    return 0;
+static uint64_t status_key(const Board *b, Color side)
+{
+    return b->hash ^ status_key_salt[side - 1];
 }
 
-// Actualiza los derechos de enroque cuando una pieza de 'side' se mueve
-static void update_castling_rights_on_move(Board *b,
-                                           Color side,
-                                           PieceType pt,
-                                           int sr, int sf)
+// Jaque y existencia de jugadas legales de 'side', consultando primero la
+// caché de estados (compartida entre hilos)
+static void lookup_status(const Board *b, Color side, int *in_check, int *has_moves)
 {
-    if (!b) return;
+    uint64_t key = status_key(b, side);
+    CachedStatus st;
 
-    if (side == COLOR_WHITE) {
-        if (pt == PIECE_KING) { // Si el rey se mueve pierde ambos enroques
-            b->white_can_castle_short = 0;
-            b->white_can_castle_long  = 0;
-        } else if (pt == PIECE_ROOK && sr == 0) { // Se mueve torre blanca
-            if (sf == 0) {          // Torre de a1
-                b->white_can_castle_long = 0;
-            } else if (sf == 7) {   // Torre de h1
-                b->white_can_castle_short = 0;
-            }
-        }
-    } else if (side == COLOR_BLACK) {
-        if (pt == PIECE_KING) { // Si el rey se mueve pierde ambos enroques
-            b->black_can_castle_short = 0;
-            b->black_can_castle_long  = 0;
-        } else if (pt == PIECE_ROOK && sr == 7) { // Se mueve torre negra
-            if (sf == 0) {          // Torre de a8
-                b->black_can_castle_long = 0;
-            } else if (sf == 7) {   // Torre de h8
-                b->black_can_castle_short = 0;
-            }
-        }
+    if (status_cache_probe(key, &st)) {
+        *in_check = st.in_check;
+        *has_moves = st.has_moves;
+        return;
     }
+
+    st.in_check = is_king_in_check(b, side);
+    st.has_moves = has_any_legal_move(b, side);
+    st.legal_moves = -1;
+    status_cache_store(key, &st);
+    *in_check = st.in_check;
+    *has_moves = st.has_moves;
 }
 
-// Actualiza los derechos de enroque cuando se captura una torre
-static void update_castling_rights_on_capture(Board *b,
-                                              const Piece *captured,
-                                              int dr, int df)
+int board_count_legal_moves(const Board *b, Color side)
 {
-    if (!b || !captured) return;
-    if (captured->type != PIECE_ROOK) return;
+    uint64_t key = status_key(b, side);
+    CachedStatus st;
 
-    if (captured->color == COLOR_WHITE && dr == 0) { // Torre blanca capturada en fila 1
-        if (df == 0) {  // a1
-            b->white_can_castle_long = 0;
-        } else if (df == 7) {  // h1
-            b->white_can_castle_short = 0;
-        }
-    } else if (captured->color == COLOR_BLACK && dr == 7) { // Torre negra capturada en fila 8
-        if (df == 0) {  // a8
-            b->black_can_castle_long = 0;
-        } else if (df == 7) {  // h8
-            b->black_can_castle_short = 0;
-        }
+    if (status_cache_probe(key, &st) && st.legal_moves >= 0) {
+        return st.legal_moves;
     }
-}
 
+    MoveList list;
+    st.in_check = is_king_in_check(b, side);
+    st.legal_moves = board_generate_legal_moves(b, side, &list);
+    st.has_moves = st.legal_moves > 0;
+    status_cache_store(key, &st);
+    return st.legal_moves;
+}
 
 // Aplica el movimiento de enroque al tablero 'b'.
 // 0 = éxito
@@ -1147,6 +1376,7 @@ static void update_castling_rights_on_capture(Board *b,
 static int apply_castling(Board *b,
                           const MoveAST *mv,
                           Color side,
+                          MoveUndo *undo,
                           char *err,
                           size_t err_sz)
 {
@@ -1158,7 +1388,7 @@ static int apply_castling(Board *b,
     Color enemy = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
 
     int king_rank, king_file_start;
-    int rook_file_start, king_file_end, rook_file_end;
+    int rook_file_start, king_file_end;
 
     // Determinar filas y columnas según el color
     if (side == COLOR_WHITE) {
@@ -1173,7 +1403,6 @@ static int apply_castling(Board *b,
             }
             rook_file_start = 7; // h
             king_file_end = 6;   // g
-            rook_file_end = 5;   // f
         } else {
             if (!b->white_can_castle_long) {
                 snprintf(err, err_sz, "Blanco no tiene derecho a enroque largo.");
@@ -1181,7 +1410,6 @@ static int apply_castling(Board *b,
             }
             rook_file_start = 0; // a
             king_file_end = 2;   // c
-            rook_file_end = 3;   // d
         }
     // Color negro
     } else {
@@ -1194,7 +1422,6 @@ static int apply_castling(Board *b,
             }
             rook_file_start = 7; // h
             king_file_end = 6;   // g
-            rook_file_end = 5;   // f
         } else {
             if (!b->black_can_castle_long) {
                 snprintf(err, err_sz, "Negro no tiene derecho a enroque largo.");
@@ -1202,19 +1429,18 @@ static int apply_castling(Board *b,
             }
             rook_file_start = 0; // a
             king_file_end = 2;   // c
-            rook_file_end = 3;   // d
         }
     }
 
     // Verificar que haya rey y torre correctos
-    Piece *king = &b->board[king_rank][king_file_start];
-    Piece *rook = &b->board[king_rank][rook_file_start];
+    const Piece king = piece_at(b, king_rank, king_file_start);
+    const Piece rook = piece_at(b, king_rank, rook_file_start);
 
-    if (king->type != PIECE_KING || king->color != side) {
+    if (king.type != PIECE_KING || king.color != side) {
         snprintf(err, err_sz, "No hay rey correcto en su casilla inicial para enrocar.");
         return -1;
     }
-    if (rook->type != PIECE_ROOK || rook->color != side) {
+    if (rook.type != PIECE_ROOK || rook.color != side) {
         snprintf(err, err_sz, "No hay torre correcta en su casilla inicial para enrocar.");
         return -1;
     }
@@ -1228,7 +1454,7 @@ static int apply_castling(Board *b,
     // 2) Las casillas entre rey y torre deben estar vacías
     int step = (rook_file_start > king_file_start) ? 1 : -1;
     for (int f = king_file_start + step; f != rook_file_start; f += step) {
-        if (b->board[king_rank][f].type != PIECE_NONE) {
+        if (b->occupied_all & SQ_BIT(SQ(king_rank, f))) {
             snprintf(err, err_sz, "No se puede enrocar: hay piezas entre rey y torre.");
             return -1;
         }
@@ -1257,24 +1483,12 @@ static int apply_castling(Board *b,
         }
     }
 
-    // 4) Aplicar enroque: mover rey y torre
-    Piece king_copy = *king;
-    Piece rook_copy = *rook;
-
-    king->type = PIECE_NONE; king->color = COLOR_NONE;
-    rook->type = PIECE_NONE; rook->color = COLOR_NONE;
-
-    b->board[king_rank][king_file_end] = king_copy;
-    b->board[king_rank][rook_file_end] = rook_copy;
-
-    // 5) Actualizar derechos de enroque
-    if (side == COLOR_WHITE) {
-        b->white_can_castle_short = 0;
-        b->white_can_castle_long = 0;
-    } else {
-        b->black_can_castle_short = 0;
-        b->black_can_castle_long = 0;
-    }
+    // 4) Aplicar enroque: mover rey y torre. Al mover el rey se pierden
+    //    ambos derechos de enroque de ese bando.
+    board_make_move(b, MOVE_MAKE(SQ(king_rank, king_file_start),
+                                 SQ(king_rank, king_file_end),
+                                 mv->is_castle_short ? MOVE_CASTLE_SHORT : MOVE_CASTLE_LONG),
+                    undo);
 
     return 0;
 }
@@ -1286,8 +1500,8 @@ PositionStatus board_evaluate_status(const Board *b, Color side_to_move)
         return POSITION_NORMAL;
     }
 
-    int in_check  = is_king_in_check(b, side_to_move);
-    int has_moves = has_any_legal_move(b, side_to_move);
+    int in_check, has_moves;
+    lookup_status(b, side_to_move, &in_check, &has_moves);
 
     if (in_check && has_moves)  return POSITION_CHECK;
     if (in_check && !has_moves) return POSITION_CHECKMATE;
@@ -1295,7 +1509,339 @@ PositionStatus board_evaluate_status(const Board *b, Color side_to_move)
     return POSITION_NORMAL;
 }
 
+// ============================================================================
+// HISTORIAL DE POSICIONES (REPETICIÓN Y REGLA DE 50 JUGADAS)
+// ============================================================================
+
+void history_init(PositionHistory *h, const Board *start)
+{
+    h->keys[0] = start->hash;
+    h->count = 1;
+    h->halfmove_clock = 0;
+    h->last_pawns = start->pieces[0][PIECE_PAWN - 1] | start->pieces[1][PIECE_PAWN - 1];
+    h->last_pieces = __builtin_popcountll(start->occupied_all);
+}
+
+void history_push(PositionHistory *h, const Board *b)
+{
+    // Una jugada de peón cambia los peones; una captura reduce las piezas
+    Bitboard pawns = b->pieces[0][PIECE_PAWN - 1] | b->pieces[1][PIECE_PAWN - 1];
+    int pieces = __builtin_popcountll(b->occupied_all);
+    if (pawns != h->last_pawns || pieces != h->last_pieces) {
+        h->halfmove_clock = 0;
+    } else {
+        h->halfmove_clock++;
+    }
+    h->last_pawns = pawns;
+    h->last_pieces = pieces;
+
+    h->keys[h->count % POSITION_HISTORY_SIZE] = b->hash;
+    h->count++;
+}
+
+int history_repetitions(const PositionHistory *h)
+{
+    int last = h->count - 1;
+    uint64_t key = h->keys[last % POSITION_HISTORY_SIZE];
+
+    // Solo posiciones con el mismo turno (cada 2 medias jugadas) desde la
+    // última jugada irreversible y que sigan en el anillo. Una partida desde
+    // FEN empieza con un reloj que puede superar las posiciones registradas:
+    // la ventana nunca pasa de la primera
+    int window = h->halfmove_clock;
+    if (window > POSITION_HISTORY_SIZE - 1) window = POSITION_HISTORY_SIZE - 1;
+    if (window > last) window = last;
+
+    int reps = 1;
+    for (int back = 2; back <= window; back += 2) {
+        if (h->keys[(last - back) % POSITION_HISTORY_SIZE] == key) reps++;
+    }
+    return reps;
+}
+
+PositionStatus history_evaluate_status(const PositionHistory *h, const Board *b,
+                                       Color side_to_move)
+{
+    PositionStatus st = board_evaluate_status(b, side_to_move);
+    if (st == POSITION_CHECKMATE || st == POSITION_STALEMATE) return st;
+
+    if (history_repetitions(h) >= 3) return POSITION_DRAW_REPETITION;
+    if (h->halfmove_clock >= 100) return POSITION_DRAW_FIFTY_MOVE;
+    return st;
+}
+
+// ============================================================================
+// POSICIONES FEN
+// ============================================================================
+
+// Letra FEN de cada tipo de pieza (mayúscula = blancas)
+static const char fen_piece_letters[] = " PNBRQK";
+
+static PieceType fen_piece_type(char c) {
+    switch (c) {
+        case 'p': case 'P': return PIECE_PAWN;
+        case 'n': case 'N': return PIECE_KNIGHT;
+        case 'b': case 'B': return PIECE_BISHOP;
+        case 'r': case 'R': return PIECE_ROOK;
+        case 'q': case 'Q': return PIECE_QUEEN;
+        case 'k': case 'K': return PIECE_KING;
+        default:            return PIECE_NONE;
+    }
+}
+
+// Lee un número sin signo; -1 si no hay dígitos
+static int fen_number(const char **p) {
+    if (**p < '0' || **p > '9') return -1;
+    int n = 0;
+    while (**p >= '0' && **p <= '9') {
+        if (n < 100000) n = n * 10 + (**p - '0');
+        (*p)++;
+    }
+    return n;
+}
+
+// Quita los derechos de enroque cuyo rey o torre no están en su casilla
+static void fen_fix_castling(Board *b) {
+    unsigned char wk = SQ_CODE(COLOR_WHITE, PIECE_KING), wr = SQ_CODE(COLOR_WHITE, PIECE_ROOK);
+    unsigned char bk = SQ_CODE(COLOR_BLACK, PIECE_KING), br = SQ_CODE(COLOR_BLACK, PIECE_ROOK);
+
+    if (b->squares[SQ(0, 4)] != wk || b->squares[SQ(0, 7)] != wr) b->white_can_castle_short = 0;
+    if (b->squares[SQ(0, 4)] != wk || b->squares[SQ(0, 0)] != wr) b->white_can_castle_long  = 0;
+    if (b->squares[SQ(7, 4)] != bk || b->squares[SQ(7, 7)] != br) b->black_can_castle_short = 0;
+    if (b->squares[SQ(7, 4)] != bk || b->squares[SQ(7, 0)] != br) b->black_can_castle_long  = 0;
+}
+
+// Lee una posición en notación FEN sin reservar memoria. Los campos de
+// enroque, en passant y contadores son opcionales (como en EPD).
+// 0 = éxito; -1 = FEN inválido o posición ilegal ('b' queda sin cambios)
+int board_from_fen(Board *b, const char *fen, Color *side_to_move,
+                   int *halfmove_clock, int *fullmove_number)
+{
+    if (!b || !fen) return -1;
+
+    Board t;
+    board_clear(&t);
+    const char *p = fen;
+    while (*p == ' ') p++;
+
+    // 1) Piezas, de la fila 8 a la 1
+    int rank = 7, file = 0;
+    for (; *p && *p != ' '; p++) {
+        if (*p == '/') {
+            if (file != 8 || rank == 0) return -1;
+            rank--;
+            file = 0;
+        } else if (*p >= '1' && *p <= '8') {
+            file += *p - '0';
+            if (file > 8) return -1;
+        } else {
+            PieceType type = fen_piece_type(*p);
+            if (type == PIECE_NONE || file > 7) return -1;
+            Color color = (*p >= 'A' && *p <= 'Z') ? COLOR_WHITE : COLOR_BLACK;
+            set_piece(&t, rank, file++, color, type);
+        }
+    }
+    if (rank != 0 || file != 8) return -1;
+
+    // 2) Turno
+    while (*p == ' ') p++;
+    Color side;
+    if (*p == 'w')      side = COLOR_WHITE;
+    else if (*p == 'b') side = COLOR_BLACK;
+    else return -1;
+    p++;
+
+    // 3) Derechos de enroque
+    while (*p == ' ') p++;
+    if (*p == '-') {
+        p++;
+    } else {
+        for (; *p && *p != ' '; p++) {
+            switch (*p) {
+                case 'K': t.white_can_castle_short = 1; break;
+                case 'Q': t.white_can_castle_long  = 1; break;
+                case 'k': t.black_can_castle_short = 1; break;
+                case 'q': t.black_can_castle_long  = 1; break;
+                default:  return -1;
+            }
+        }
+    }
+    fen_fix_castling(&t);
+
+    // 4) Casilla de en passant: fila 6 si juegan las blancas, 3 si las negras,
+    //    con el peón que acaba de avanzar dos casillas delante
+    while (*p == ' ') p++;
+    if (*p == '-') {
+        p++;
+    } else if (*p >= 'a' && *p <= 'h') {
+        int ef = *p++ - 'a';
+        int er = (side == COLOR_WHITE) ? 5 : 2;
+        if (*p++ != '1' + er) return -1;
+        Color pusher = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+        int pawn_rank = (side == COLOR_WHITE) ? 4 : 3;
+        if (t.squares[SQ(pawn_rank, ef)] != SQ_CODE(pusher, PIECE_PAWN)) return -1;
+        if (t.squares[SQ(er, ef)]) return -1;
+        t.en_passant_file = (signed char)ef;
+        t.en_passant_rank = (signed char)er;
+    } else if (*p) {
+        return -1;
+    }
+
+    // 5) Contadores de medias jugadas y de jugadas
+    int halfmove = 0, fullmove = 1;
+    while (*p == ' ') p++;
+    if (*p) {
+        if ((halfmove = fen_number(&p)) < 0) return -1;
+        while (*p == ' ') p++;
+        if (*p && (fullmove = fen_number(&p)) < 0) return -1;
+        while (*p == ' ') p++;
+        if (*p) return -1;
+    }
+    if (fullmove < 1) fullmove = 1;
+
+    // 6) Legalidad básica: un rey por bando, sin peones en la primera ni la
+    //    última fila, y el bando que no juega no puede estar en jaque
+    Bitboard back_ranks = 0xFF000000000000FFULL;
+    if (__builtin_popcountll(t.pieces[0][PIECE_KING - 1]) != 1 ||
+        __builtin_popcountll(t.pieces[1][PIECE_KING - 1]) != 1) return -1;
+    if ((t.pieces[0][PIECE_PAWN - 1] | t.pieces[1][PIECE_PAWN - 1]) & back_ranks) return -1;
+    if (is_king_in_check(&t, (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE)) return -1;
+
+    t.hash = board_compute_hash(&t, side);
+    *b = t;
+    if (side_to_move)    *side_to_move = side;
+    if (halfmove_clock)  *halfmove_clock = halfmove;
+    if (fullmove_number) *fullmove_number = fullmove;
+    return 0;
+}
 
+// Escribe la posición en notación FEN. Devuelve la longitud escrita, o -1
+// si no cabe en 'out'
+int board_to_fen(const Board *b, Color side_to_move, int halfmove_clock,
+                 int fullmove_number, char *out, size_t out_size)
+{
+    char buf[BOARD_FEN_MAX];
+    int n = 0;
+
+    for (int r = 7; r >= 0; --r) {
+        int empty = 0;
+        for (int f = 0; f < 8; ++f) {
+            unsigned char code = b->squares[SQ(r, f)];
+            if (!code) {
+                empty++;
+                continue;
+            }
+            if (empty) buf[n++] = (char)('0' + empty);
+            empty = 0;
+            char c = fen_piece_letters[CODE_TYPE(code)];
+            buf[n++] = (CODE_COLOR(code) == COLOR_WHITE) ? c : (char)(c + ('a' - 'A'));
+        }
+        if (empty) buf[n++] = (char)('0' + empty);
+        if (r > 0) buf[n++] = '/';
+    }
+
+    buf[n++] = ' ';
+    buf[n++] = (side_to_move == COLOR_BLACK) ? 'b' : 'w';
+    buf[n++] = ' ';
+
+    int castle_start = n;
+    if (b->white_can_castle_short) buf[n++] = 'K';
+    if (b->white_can_castle_long)  buf[n++] = 'Q';
+    if (b->black_can_castle_short) buf[n++] = 'k';
+    if (b->black_can_castle_long)  buf[n++] = 'q';
+    if (n == castle_start) buf[n++] = '-';
+    buf[n++] = ' ';
+
+    if (b->en_passant_file >= 0 && b->en_passant_rank >= 0) {
+        buf[n++] = (char)('a' + b->en_passant_file);
+        buf[n++] = (char)('1' + b->en_passant_rank);
+    } else {
+        buf[n++] = '-';
+    }
+
+    n += snprintf(buf + n, sizeof(buf) - n, " %d %d", halfmove_clock, fullmove_number);
+
+    if (!out || (size_t)n >= out_size) return -1;
+    memcpy(out, buf, (size_t)n + 1);
+    return n;
+}
+
+
+
+// Escribe en 'out' la notación SAN de un movimiento legal de la posición
+// 'b' (desambiguación y sufijos +/# incluidos). Devuelve la longitud escrita.
+int board_move_to_san(Board *b, Move m, char *out, size_t out_size)
+{
+    static const char piece_letters[] = " PNBRQK";
+    char buf[16];
+    int n = 0;
+
+    if (!b || !out || out_size == 0) return 0;
+
+    int from = MOVE_FROM(m), to = MOVE_TO(m), kind = MOVE_KIND(m);
+    unsigned char code = b->squares[from];
+    PieceType pt = CODE_TYPE(code);
+    Color side = CODE_COLOR(code);
+
+    if (kind == MOVE_CASTLE_SHORT) {
+        n += sprintf(buf + n, "O-O");
+    } else if (kind == MOVE_CASTLE_LONG) {
+        n += sprintf(buf + n, "O-O-O");
+    } else {
+        int is_capture = (b->squares[to] != 0) || kind == MOVE_EN_PASSANT;
+
+        if (pt == PIECE_PAWN) {
+            if (is_capture) buf[n++] = (char)('a' + from % 8);
+        } else {
+            buf[n++] = piece_letters[pt];
+
+            // Desambiguación: otras piezas del mismo tipo que llegan al destino
+            MoveList list;
+            int same_file = 0, same_rank = 0, others = 0;
+            board_generate_legal_moves(b, side, &list);
+            for (int i = 0; i < list.count; ++i) {
+                int f2 = MOVE_FROM(list.moves[i]);
+                if (MOVE_TO(list.moves[i]) != to || f2 == from) continue;
+                if (CODE_TYPE(b->squares[f2]) != pt) continue;
+                others++;
+                if (f2 % 8 == from % 8) same_file = 1;
+                if (f2 / 8 == from / 8) same_rank = 1;
+            }
+            if (others) {
+                if (!same_file) {
+                    buf[n++] = (char)('a' + from % 8);
+                } else if (!same_rank) {
+                    buf[n++] = (char)('1' + from / 8);
+                } else {
+                    buf[n++] = (char)('a' + from % 8);
+                    buf[n++] = (char)('1' + from / 8);
+                }
+            }
+        }
+
+        if (is_capture) buf[n++] = 'x';
+        buf[n++] = (char)('a' + to % 8);
+        buf[n++] = (char)('1' + to / 8);
+
+        if (MOVE_IS_PROMOTION(m)) {
+            buf[n++] = '=';
+            buf[n++] = piece_letters[MOVE_PROMOTION_PIECE(m)];
+        }
+    }
+
+    // Sufijo de jaque / jaque mate
+    MoveUndo undo;
+    Color enemy = (side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    board_make_move(b, m, &undo);
+    PositionStatus st = board_evaluate_status(b, enemy);
+    board_unmake_move(b, &undo);
+    if (st == POSITION_CHECKMATE)  buf[n++] = '#';
+    else if (st == POSITION_CHECK) buf[n++] = '+';
+    buf[n] = '\0';
+
+    snprintf(out, out_size, "%s", buf);
+    return n;
+}
 
 int board_apply_move(Board *b,
                      const MoveAST *mv,
@@ -1303,29 +1849,101 @@ int board_apply_move(Board *b,
                      char *error_msg,
                      size_t error_msg_size)
 {
-    if (!b || !mv) {
+    return board_apply_move_ex(b, mv, side_to_move, NULL, error_msg, error_msg_size);
+}
+
+// Comprueba que los sufijos +/# de 'mv' coincidan con la posición 'b', ya
+// con la jugada hecha. 0 = coinciden, -1 = no (mensaje en error_msg)
+static int check_annotation(const Board *b, const MoveAST *mv, Color enemy,
+                            char *error_msg, size_t error_msg_size)
+{
+    int enemy_in_check, enemy_has_moves;
+    lookup_status(b, enemy, &enemy_in_check, &enemy_has_moves);
+
+    int expect_check = (mv->is_check || mv->is_mate);
+
+    // Caso 1: se marcó + o # pero el rey enemigo NO está en jaque
+    if (expect_check && !enemy_in_check) {
+        snprintf(error_msg, error_msg_size,
+                 "Movimiento %s está anotado como jaque/jaque mate, "
+                 "pero el rey enemigo no está en jaque.", mv->raw);
+        return -1;
+    }
+
+    // Caso 2: NO se marcó + ni # pero el rey enemigo SÍ está en jaque
+    if (!expect_check && enemy_in_check) {
+        snprintf(error_msg, error_msg_size,
+                 "Movimiento %s da jaque, pero no está marcado con '+' o '#'.",
+                 mv->raw);
+        return -1;
+    }
+
+    // Caso 3: se marcó # pero NO es jaque mate (tiene jugadas legales)
+    if (mv->is_mate && enemy_in_check && enemy_has_moves) {
+        snprintf(error_msg, error_msg_size,
+                 "Movimiento %s está anotado como jaque mate ('#'), "
+                 "pero el rival aún tiene movimientos legales.", mv->raw);
+        return -1;
+    }
+
+    // Caso 4: NO se marcó # pero en realidad es jaque mate
+    if (!mv->is_mate && enemy_in_check && !enemy_has_moves) {
+        snprintf(error_msg, error_msg_size,
+                 "Movimiento %s produce jaque mate, pero no está marcado con '#'.",
+                 mv->raw);
+        return -1;
+    }
+    return 0;
+}
+
+int board_apply_move_ex(Board *b,
+                        const MoveAST *mv,
+                        Color side_to_move,
+                        Move *out_move,
+                        char *error_msg,
+                        size_t error_msg_size)
+{
+    MoveUndo undo;
+    if (board_apply_move_undo(b, mv, side_to_move, &undo, error_msg, error_msg_size) != 0) {
+        return -1;
+    }
+    if (out_move) *out_move = undo.move;
+    return 0;
+}
+
+int board_apply_move_undo(Board *b,
+                          const MoveAST *mv,
+                          Color side_to_move,
+                          MoveUndo *undo,
+                          char *error_msg,
+                          size_t error_msg_size)
+{
+    if (!b || !mv || !undo) {
         snprintf(error_msg, error_msg_size, "Argumentos nulos en board_apply_move");
         return -1;
     }
 
     // 1) Caso especial: enroque
     if (mv->is_castle_short || mv->is_castle_long) {
-        Board tmp = *b;
-
-        // Intentar aplicar el enroque en el tablero temporal
-        if (apply_castling(&tmp, mv, side_to_move, error_msg, error_msg_size) != 0) {
+        // Intentar aplicar el enroque (si falla, el tablero no se modifica)
+        if (apply_castling(b, mv, side_to_move, undo, error_msg, error_msg_size) != 0) {
             return -1;
         }
 
         // Validar que el rey no quede en jaque después del enroque
-        if (is_king_in_check(&tmp, side_to_move)) {
+        if (is_king_in_check(b, side_to_move)) {
+            board_unmake_move(b, undo);
             snprintf(error_msg, error_msg_size,
                     "Enroque ilegal: el rey quedaría en jaque.");
             return -1;
         }
 
-        // Si es legal, aplicar en el tablero real
-        *b = tmp;
+        // Los sufijos +/# se validan igual que en el resto de jugadas
+        Color enemy = (side_to_move == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+        if (check_annotation(b, mv, enemy, error_msg, error_msg_size) != 0) {
+            board_unmake_move(b, undo);
+            return -1;
+        }
         return 0;
     }
 
@@ -1406,28 +2024,23 @@ int board_apply_move(Board *b,
     else if (pt == PIECE_KING) {
         int found = 0;
 
-        for (int r = 0; r < 8; ++r) {
-            for (int f = 0; f < 8; ++f) {
-                Piece *p = &b->board[r][f];
-
-                if (p->type == PIECE_KING && p->color == side_to_move) {
-
-                    // ¿Puede este rey ir a (dr, df)?
-                    if (!can_king_move(b, r, f, dr, df, mv->is_capture, side_to_move)) {
-                        snprintf(error_msg, error_msg_size,
-                                "Movimiento ilegal del rey: no puede ir a %c%c",
-                                mv->dest_file, mv->dest_rank);
-                        return -1;
-                    }
+        Bitboard king = b->pieces[side_to_move - 1][PIECE_KING - 1];
+        if (king) {
+            int s = bb_lsb(king);
+            int r = s / 8, f = s % 8;
 
-                    // Guardar origen
-                    sr = r;
-                    sf = f;
-                    found = 1;
-                    break;
-                }
+            // ¿Puede este rey ir a (dr, df)?
+            if (!can_king_move(b, r, f, dr, df, mv->is_capture, side_to_move)) {
+                snprintf(error_msg, error_msg_size,
+                        "Movimiento ilegal del rey: no puede ir a %c%c",
+                        mv->dest_file, mv->dest_rank);
+                return -1;
             }
-            if (found) break;
+
+            // Guardar origen
+            sr = r;
+            sf = f;
+            found = 1;
         }
 
         if (!found) {
@@ -1442,13 +2055,10 @@ int board_apply_move(Board *b,
         return -1;
     }
 
-    // 6) Simular el movimiento en un tablero temporal 
-
-    Board tmp = *b;
+    // 6) Construir el movimiento y aplicarlo con make/unmake
 
     // Piezas involucradas antes de mover
-    Piece moving_before = tmp.board[sr][sf];
-    Piece captured_before = tmp.board[dr][df];  // puede ser NONE
+    Piece captured_before = piece_at(b, dr, df);  // puede ser NONE
 
     // Detectar si esta jugada es una captura al paso
     int is_en_passant_capture = 0;
@@ -1468,22 +2078,10 @@ int board_apply_move(Board *b,
         return -1;
     }
 
-    // Actualizar derechos de enroque en el tablero temporal:
-    update_castling_rights_on_move(&tmp, side_to_move, pt, sr, sf);
-    update_castling_rights_on_capture(&tmp, &captured_before, dr, df);
-
-    // Aplicar el movimiento en tmp
-    Piece moving = moving_before;
+    int kind = MOVE_NORMAL;
 
-    // Vaciar la casilla origen
-    tmp.board[sr][sf].type = PIECE_NONE;
-    tmp.board[sr][sf].color = COLOR_NONE;
-
-    // Si es captura al paso, eliminar el peón enemigo en la casilla correcta
     if (is_en_passant_capture) {
-        int pawn_rank = (side_to_move == COLOR_WHITE) ? dr - 1 : dr + 1;
-        tmp.board[pawn_rank][df].type  = PIECE_NONE;
-        tmp.board[pawn_rank][df].color = COLOR_NONE;
+        kind = MOVE_EN_PASSANT;
     }
 
     // Manejar promoción de peón
@@ -1499,73 +2097,38 @@ int board_apply_move(Board *b,
                      mv->promotion);
             return -1;
         }
-        moving.type = promo_type;
+        kind = MOVE_PROMO_KNIGHT + (promo_type - PIECE_KNIGHT);
     }
 
-    // Colocar la pieza en la casilla destino
-    tmp.board[dr][df] = moving;
-
-    tmp.en_passant_file = -1;
-    tmp.en_passant_rank = -1;
-
     if (pt == PIECE_PAWN && !mv->is_capture) {
         int dir = (side_to_move == COLOR_WHITE) ? 1 : -1;
         // Si el peón avanzó dos casillas, hay posibilidad de en passant
         if (dr - sr == 2 * dir) {
-            tmp.en_passant_file = df;
-            tmp.en_passant_rank = sr + dir; // casilla intermedia que "saltó"
+            kind = MOVE_DOUBLE_PUSH;
         }
     }
 
+    // Aplica el movimiento (derechos de enroque y en passant incluidos);
+    // si resulta ilegal se deshace con el registro 'undo'
+    board_make_move(b, MOVE_MAKE(SQ(sr, sf), SQ(dr, df), kind), undo);
+    Color enemy = (side_to_move == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    status_cache_prefetch(status_key(b, enemy));   // se consulta en el paso 8
+
     // 7) Validar si el rey propio queda en jaque en la posición resultante
-    if (is_king_in_check(&tmp, side_to_move)) {
+    if (is_king_in_check(b, side_to_move)) {
+        board_unmake_move(b, undo);
         snprintf(error_msg, error_msg_size,
                  "Movimiento ilegal: el rey quedaría en jaque tras %s", mv->raw);
         return -1;
     }
 
     // 8) Validar coherencia de jaque y jaque mate
-    Color enemy = (side_to_move == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
-    int enemy_in_check   = is_king_in_check(&tmp, enemy);
-    int enemy_has_moves  = has_any_legal_move(&tmp, enemy);
-
-    int expect_check = (mv->is_check || mv->is_mate);
-
-    // Caso 1: se marcó + o # pero el rey enemigo NO está en jaque
-    if (expect_check && !enemy_in_check) {
-        snprintf(error_msg, error_msg_size,
-                 "Movimiento %s está anotado como jaque/jaque mate, "
-                 "pero el rey enemigo no está en jaque.", mv->raw);
-        return -1;
-    }
-
-    // Caso 2: NO se marcó + ni # pero el rey enemigo SÍ está en jaque
-    if (!expect_check && enemy_in_check) {
-        snprintf(error_msg, error_msg_size,
-                 "Movimiento %s da jaque, pero no está marcado con '+' o '#'.",
-                 mv->raw);
-        return -1;
-    }
-
-    // Caso 3: se marcó # pero NO es jaque mate (tiene jugadas legales)
-    if (mv->is_mate && enemy_in_check && enemy_has_moves) {
-        snprintf(error_msg, error_msg_size,
-                 "Movimiento %s está anotado como jaque mate ('#'), "
-                 "pero el rival aún tiene movimientos legales.", mv->raw);
-        return -1;
-    }
-
-    // Caso 4: NO se marcó # pero en realidad es jaque mate
-    if (!mv->is_mate && enemy_in_check && !enemy_has_moves) {
-        snprintf(error_msg, error_msg_size,
-                 "Movimiento %s produce jaque mate, pero no está marcado con '#'.",
-                 mv->raw);
+    if (check_annotation(b, mv, enemy, error_msg, error_msg_size) != 0) {
+        board_unmake_move(b, undo);
         return -1;
     }
-    
-    // 8) Si es legal, copiar tablero temporal al real
-    *b = tmp;
 
+    // 9) Si es legal, el movimiento queda aplicado en el tablero real
     return 0;
 }
 
@@ -1619,16 +2182,16 @@ void board_print(const Board *b) {
         printf("%d ║", r + 1);
 
         for (int f = 0; f < 8; ++f) {
-            const Piece *p = &b->board[r][f];
-            const char *symbol = piece_to_unicode(p);
+            const Piece p = piece_at(b, r, f);
+            const char *symbol = piece_to_unicode(&p);
 
             // Determinar si la casilla es clara u oscura
             int is_light = (r + f) % 2 == 0;
 
             // Determinar estilo de la pieza (bold para blancas, normal para negras)
             const char *piece_style = "";
-            if (p->type != PIECE_NONE) {
-                piece_style = (p->color == COLOR_WHITE) ? ANSI_BOLD : ANSI_NORMAL;
+            if (p.type != PIECE_NONE) {
+                piece_style = (p.color == COLOR_WHITE) ? ANSI_BOLD : ANSI_NORMAL;
             }
 
             // Aplicar color de casilla (inverso para oscuras, normal para claras)
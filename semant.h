@@ -1,6 +1,7 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <stdint.h>
 #include "ast.h"
 
 // Color de la pieza
@@ -28,7 +29,37 @@ typedef struct {
     PieceType type;
 } Piece;
 
+// Máscara de 64 bits: bit (rank * 8 + file) = casilla, a1 = bit 0, h8 = bit 63
+typedef uint64_t Bitboard;
 
+// Tablero representado con bitboards
+typedef struct {
+    Bitboard pieces[2][6];      // Una máscara por color y tipo: [color - 1][tipo - 1]
+    Bitboard occupied[2];       // Ocupación por color: [color - 1]
+    Bitboard occupied_all;      // Ocupación total
+
+    // Pieza en cada casilla (acceso directo): (color << 3) | tipo, 0 = vacía
+    unsigned char squares[64];
+
+    // Validación de enroques
+    unsigned char white_can_castle_short;
+    unsigned char white_can_castle_long;
+    unsigned char black_can_castle_short;
+    unsigned char black_can_castle_long;
+
+    // Variable de en passant
+    signed char en_passant_file;
+    signed char en_passant_rank;
+
+    // Clave Zobrist (piezas, turno, enroques y en passant), actualizada en
+    // cada movimiento. Las posiciones creadas con board_init_* y
+    // board_from_grid se consideran con turno de las blancas; board_from_fen
+    // usa el turno del FEN.
+    uint64_t hash;
+} Board;
+
+// Representación anterior del tablero (matriz 8x8 de piezas).
+// Se conserva para convertir desde/hacia Board.
 typedef struct {
     Piece board[8][8];
 
@@ -41,18 +72,91 @@ typedef struct {
     // Variable de en passant
     int en_passant_file;
     int en_passant_rank;
-} Board;
+} BoardGrid;
+
+// Movimiento codificado en 16 bits:
+//   bits 0-5   casilla origen  (rank * 8 + file)
+//   bits 6-11  casilla destino
+//   bits 12-15 tipo de movimiento (MOVE_*)
+typedef uint16_t Move;
+
+// Tipos de movimiento (bits 12-15 de Move)
+enum {
+    MOVE_NORMAL        = 0,
+    MOVE_DOUBLE_PUSH   = 1,   // Peón avanza dos casillas
+    MOVE_CASTLE_SHORT  = 2,
+    MOVE_CASTLE_LONG   = 3,
+    MOVE_EN_PASSANT    = 4,
+    MOVE_PROMO_KNIGHT  = 8,   // Promociones: 8 + (pieza - PIECE_KNIGHT)
+    MOVE_PROMO_BISHOP  = 9,
+    MOVE_PROMO_ROOK    = 10,
+    MOVE_PROMO_QUEEN   = 11
+};
+
+#define MOVE_MAKE(from, to, kind) ((Move)((from) | ((to) << 6) | ((kind) << 12)))
+#define MOVE_FROM(m)              ((int)((m) & 63))
+#define MOVE_TO(m)                ((int)(((m) >> 6) & 63))
+#define MOVE_KIND(m)              ((int)((m) >> 12))
+#define MOVE_IS_PROMOTION(m)      (MOVE_KIND(m) >= MOVE_PROMO_KNIGHT)
+#define MOVE_PROMOTION_PIECE(m)   ((PieceType)(PIECE_KNIGHT + (MOVE_KIND(m) & 3)))
+
+// Lista de movimientos (ninguna posición legal tiene más de 218)
+typedef struct {
+    Move moves[256];
+    int count;
+} MoveList;
+
+// Datos para deshacer un movimiento hecho con board_make_move
+typedef struct {
+    Move move;
+    unsigned char captured;     // Pieza capturada: (color << 3) | tipo, 0 = ninguna
+    unsigned char castling;     // Derechos de enroque previos (bits: 1 = blanco corto,
+                                // 2 = blanco largo, 4 = negro corto, 8 = negro largo)
+    signed char en_passant_sq;  // Casilla de en passant previa (rank * 8 + file), -1 = ninguna
+    uint64_t hash;              // Clave Zobrist previa
+} MoveUndo;
 
 // Estado de la posición
 typedef enum {
     POSITION_NORMAL,
     POSITION_CHECK,
     POSITION_CHECKMATE,
-    POSITION_STALEMATE
+    POSITION_STALEMATE,
+    POSITION_DRAW_REPETITION,   // La posición se repitió 3 veces
+    POSITION_DRAW_FIFTY_MOVE    // 50 jugadas sin capturas ni movimientos de peón
 } PositionStatus;
 
 PositionStatus board_evaluate_status(const Board *b, Color side_to_move);
 
+// Posiciones recordadas por PositionHistory (potencia de 2). Cubre de sobra
+// las 100 medias jugadas de la regla de 50 jugadas.
+#define POSITION_HISTORY_SIZE 256
+
+// Historial de una partida para detectar repeticiones y la regla de 50
+// jugadas. Guarda las claves Zobrist en un anillo fijo (sin reservar memoria)
+typedef struct {
+    uint64_t keys[POSITION_HISTORY_SIZE];
+    int count;                  // Posiciones registradas (incluida la inicial)
+    int halfmove_clock;         // Medias jugadas desde la última captura o jugada de peón
+    Bitboard last_pawns;        // Peones y cantidad de piezas de la última posición,
+    int last_pieces;            // para saber si la jugada fue irreversible
+} PositionHistory;
+
+// Empieza el historial con la posición inicial de la partida
+void history_init(PositionHistory *h, const Board *start);
+
+// Registra la posición que quedó tras una jugada
+void history_push(PositionHistory *h, const Board *b);
+
+// Veces que apareció la posición actual (1 = primera vez). Solo compara con
+// las posiciones posteriores a la última jugada irreversible.
+int history_repetitions(const PositionHistory *h);
+
+// Como board_evaluate_status, y además informa tablas por triple repetición
+// o por la regla de 50 jugadas (el mate tiene prioridad)
+PositionStatus history_evaluate_status(const PositionHistory *h, const Board *b,
+                                       Color side_to_move);
+
 
 // Convierte a index
 int file_to_index(char file);
@@ -63,7 +167,47 @@ void board_init_start(Board *b);
 
 void board_init_stalemate_test(Board *b);
 
-// Imprime el tablero 
+// Devuelve la pieza en (rank, file); PIECE_NONE/COLOR_NONE si está vacía
+Piece board_piece_at(const Board *b, int rank, int file);
+
+// Genera todas las jugadas legales de 'side' en la lista.
+// Devuelve la cantidad de jugadas (también queda en list->count).
+int board_generate_legal_moves(const Board *b, Color side, MoveList *list);
+
+// Cantidad de jugadas legales de 'side' (usa la caché de estados)
+int board_count_legal_moves(const Board *b, Color side);
+
+// Aplica un movimiento sin validar su legalidad (por ejemplo, uno generado
+// por board_generate_legal_moves) y guarda en 'undo' cómo deshacerlo
+void board_make_move(Board *b, Move m, MoveUndo *undo);
+
+// Deshace el movimiento registrado en 'undo' (debe ser el último aplicado)
+void board_unmake_move(Board *b, const MoveUndo *undo);
+
+// Calcula desde cero la clave Zobrist de la posición con turno de 'side_to_move'
+// (board_make_move la mantiene en b->hash de forma incremental)
+uint64_t board_compute_hash(const Board *b, Color side_to_move);
+
+// 1 si la casilla (rank, file) está atacada por el bando 'by_side'
+int board_is_square_attacked(const Board *b, int rank, int file, Color by_side);
+
+// Longitud máxima de un FEN escrito por board_to_fen (con el '\0')
+#define BOARD_FEN_MAX 128
+
+// Lee una posición FEN (sin reservar memoria); los punteros de salida
+// pueden ser NULL. 0 = éxito, -1 = FEN inválido o posición ilegal
+int board_from_fen(Board *b, const char *fen, Color *side_to_move,
+                   int *halfmove_clock, int *fullmove_number);
+
+// Escribe la posición en FEN. Devuelve la longitud, o -1 si no cabe
+int board_to_fen(const Board *b, Color side_to_move, int halfmove_clock,
+                 int fullmove_number, char *out, size_t out_size);
+
+// Conversión entre la matriz 8x8 y los bitboards
+void board_from_grid(Board *b, const BoardGrid *g);
+void board_to_grid(const Board *b, BoardGrid *g);
+
+// Imprime el tablero
 void board_print(const Board *b);
 
 /* Aplica un movimiento ya parseado (MoveAST) al tablero.
@@ -76,4 +220,28 @@ int board_apply_move(Board *b,
                      char *error_msg,
                      size_t error_msg_size);
 
-#endif 
\ No newline at end of file
+// Igual que board_apply_move; si el movimiento es legal y out_move no es
+// NULL, devuelve además su codificación de 16 bits
+int board_apply_move_ex(Board *b,
+                        const MoveAST *mv,
+                        Color side_to_move,
+                        Move *out_move,
+                        char *error_msg,
+                        size_t error_msg_size);
+
+// Igual que board_apply_move; si el movimiento es legal deja en 'undo' los
+// datos para deshacerlo con board_unmake_move
+int board_apply_move_undo(Board *b,
+                          const MoveAST *mv,
+                          Color side_to_move,
+                          MoveUndo *undo,
+                          char *error_msg,
+                          size_t error_msg_size);
+
+// Escribe la notación SAN de un movimiento legal de la posición 'b'
+// (con desambiguación y sufijo +/#). Devuelve la longitud escrita.
+// Para el sufijo hace y deshace la jugada sobre 'b', que queda como estaba
+// (no debe usarse a la vez desde otro hilo).
+int board_move_to_san(Board *b, Move m, char *out, size_t out_size);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,489 @@
+// server.c - Servidor de partidas en vivo con epoll
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "semant.h"
+#include "game_session.h"
+#include "server.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// Línea más larga que se acepta (un FEN con el comando cabe de sobra)
+#define CONN_IN_SIZE 1024
+// Respuestas pendientes de enviar por conexión
+#define CONN_OUT_SIZE 4096
+// Respuesta más larga posible: solo se procesa un comando si cabe
+#define RESPONSE_MAX 512
+#define EVENT_BATCH 256
+
+typedef struct {
+    int fd;
+    GameSession *game;                // NULL hasta el primer NEW
+    char in[CONN_IN_SIZE];
+    int in_len;
+    char out[CONN_OUT_SIZE];
+    int out_len;
+    int out_pos;                      // Bytes de 'out' ya enviados
+    unsigned events;                  // Eventos registrados en epoll
+    int closing;                      // QUIT: cerrar tras enviar lo pendiente
+    int discarding;                   // Descartando el resto de una línea demasiado larga
+} Connection;
+
+typedef struct {
+    int epoll_fd;
+    int listen_fd;
+    int undo_depth;
+    int max_clients;
+    int clients;
+    long accepted;
+    long commands;
+    long moves;
+} Server;
+
+static volatile sig_atomic_t server_stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    server_stop = 1;
+}
+
+// ============================================================================
+// SOCKETS
+// ============================================================================
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return (flags < 0) ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static int listen_unix(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Ruta de socket demasiado larga: %s\n", path);
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);   // Socket de una ejecución anterior
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listen_tcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror("127.0.0.1");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// ============================================================================
+// CONEXIONES
+// ============================================================================
+
+static void conn_close(Server *srv, Connection *c) {
+    epoll_ctl(srv->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    game_session_free(c->game);
+    free(c);
+    srv->clients--;
+}
+
+// Registra en epoll los eventos que la conexión necesita: lectura mientras
+// haya lugar para la entrada y para responder, escritura si hay pendientes
+static void conn_update_events(Server *srv, Connection *c) {
+    unsigned events = 0;
+    int pending = c->out_len > c->out_pos;
+    if (!c->closing && c->in_len < CONN_IN_SIZE && CONN_OUT_SIZE - c->out_len >= RESPONSE_MAX) {
+        events |= EPOLLIN;
+    }
+    if (pending) events |= EPOLLOUT;
+    if (events == c->events) return;
+
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = c;
+    epoll_ctl(srv->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->events = events;
+}
+
+// Envía lo pendiente. 0 = sigue abierta, -1 = el cliente se fue
+static int conn_flush(Connection *c) {
+    while (c->out_pos < c->out_len) {
+        ssize_t n = send(c->fd, c->out + c->out_pos, (size_t)(c->out_len - c->out_pos), MSG_NOSIGNAL);
+        if (n > 0) {
+            c->out_pos += (int)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return -1;
+        }
+    }
+    if (c->out_pos == c->out_len) {
+        c->out_pos = 0;
+        c->out_len = 0;
+    } else if (c->out_pos > CONN_OUT_SIZE / 2) {
+        memmove(c->out, c->out + c->out_pos, (size_t)(c->out_len - c->out_pos));
+        c->out_len -= c->out_pos;
+        c->out_pos = 0;
+    }
+    return 0;
+}
+
+// Agrega a la salida la línea "tag [a [b]]"
+static void conn_reply(Connection *c, const char *tag, const char *a, const char *b) {
+    int room = CONN_OUT_SIZE - c->out_len;
+    int n;
+    if (b) {
+        n = snprintf(c->out + c->out_len, (size_t)room, "%s %s %s\n", tag, a, b);
+    } else if (a) {
+        n = snprintf(c->out + c->out_len, (size_t)room, "%s %s\n", tag, a);
+    } else {
+        n = snprintf(c->out + c->out_len, (size_t)room, "%s\n", tag);
+    }
+    if (n >= room) n = room - 1;   // No pasa: hay al menos RESPONSE_MAX libres
+    c->out_len += n;
+}
+
+// ============================================================================
+// PROTOCOLO
+// ============================================================================
+
+// Ejecuta un comando (línea sin el salto de línea, terminada en '\0')
+static void conn_command(Server *srv, Connection *c, char *line) {
+    srv->commands++;
+    while (*line == ' ') line++;
+    char *arg = line;
+    while (*arg && *arg != ' ') arg++;
+    if (*arg) *arg++ = '\0';
+    while (*arg == ' ') arg++;
+    size_t arg_len = strlen(arg);
+    while (arg_len > 0 && arg[arg_len - 1] == ' ') arg[--arg_len] = '\0';
+
+    if (strcasecmp(line, "NEW") == 0) {
+        GameSession *g = game_session_create(arg_len ? arg : NULL, srv->undo_depth);
+        if (!g) {
+            conn_reply(c, "ERR", arg_len ? "FEN inválido" : "sin memoria", NULL);
+            return;
+        }
+        game_session_free(c->game);
+        c->game = g;
+        conn_reply(c, "OK", NULL, NULL);
+        return;
+    }
+    if (strcasecmp(line, "QUIT") == 0) {
+        conn_reply(c, "OK", NULL, NULL);
+        c->closing = 1;
+        return;
+    }
+
+    int is_move = strcasecmp(line, "MOVE") == 0;
+    int is_undo = strcasecmp(line, "UNDO") == 0;
+    int is_fen = strcasecmp(line, "FEN") == 0;
+    int is_status = strcasecmp(line, "STATUS") == 0;
+    if (!is_move && !is_undo && !is_fen && !is_status) {
+        conn_reply(c, "ERR", "comando desconocido", NULL);
+        return;
+    }
+    if (!c->game) {
+        conn_reply(c, "ERR", "no hay partida (use NEW)", NULL);
+        return;
+    }
+
+    if (is_move) {
+        GameSessionMove mv;
+        if (arg_len == 0) {
+            conn_reply(c, "ERR", "falta la jugada", NULL);
+        } else if (game_session_push_san(c->game, arg, arg_len, &mv) != 0) {
+            conn_reply(c, "ERR", mv.error, NULL);
+        } else {
+            srv->moves++;
+            conn_reply(c, "OK", mv.san, game_session_status_name(mv.status));
+        }
+    } else if (is_undo) {
+        if (game_session_undo(c->game) != 0) {
+            conn_reply(c, "ERR", "no hay jugadas para deshacer", NULL);
+        } else {
+            conn_reply(c, "OK", game_session_status_name(game_session_status(c->game)), NULL);
+        }
+    } else if (is_fen) {
+        char fen[BOARD_FEN_MAX];
+        game_session_fen(c->game, fen, sizeof(fen));
+        conn_reply(c, "OK", fen, NULL);
+    } else {
+        conn_reply(c, "OK", game_session_status_name(game_session_status(c->game)),
+                   game_session_side_to_move(c->game) == COLOR_WHITE ? "white" : "black");
+    }
+}
+
+// Ejecuta las líneas completas de la entrada mientras haya lugar para
+// responder; las que no entran esperan a que el cliente lea
+static void conn_process(Server *srv, Connection *c) {
+    int start = 0;
+    if (c->discarding) {
+        char *nl = memchr(c->in, '\n', (size_t)c->in_len);
+        if (!nl) {
+            c->in_len = 0;
+            return;
+        }
+        start = (int)(nl - c->in) + 1;
+        c->discarding = 0;
+    }
+    while (!c->closing && CONN_OUT_SIZE - c->out_len >= RESPONSE_MAX) {
+        char *nl = memchr(c->in + start, '\n', (size_t)(c->in_len - start));
+        if (!nl) break;
+        *nl = '\0';
+        if (nl > c->in + start && nl[-1] == '\r') nl[-1] = '\0';
+        conn_command(srv, c, c->in + start);
+        start = (int)(nl - c->in) + 1;
+    }
+    if (start > 0) {
+        memmove(c->in, c->in + start, (size_t)(c->in_len - start));
+        c->in_len -= start;
+    }
+
+    // Línea que no entra en el búfer: se descarta hasta el próximo salto
+    if (c->in_len == CONN_IN_SIZE && CONN_OUT_SIZE - c->out_len >= RESPONSE_MAX) {
+        conn_reply(c, "ERR", "línea demasiado larga", NULL);
+        c->in_len = 0;
+        c->discarding = 1;
+    }
+}
+
+// Lee lo disponible. 0 = sigue abierta, -1 = el cliente se fue
+static int conn_read(Connection *c) {
+    if (c->in_len == CONN_IN_SIZE) return 0;   // Espera a que se procese la entrada
+    for (;;) {
+        ssize_t n = read(c->fd, c->in + c->in_len, (size_t)(CONN_IN_SIZE - c->in_len));
+        if (n > 0) {
+            c->in_len += (int)n;
+            return 0;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+        return -1;
+    }
+}
+
+static void server_accept(Server *srv) {
+    for (;;) {
+        int fd = accept(srv->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            // EAGAIN: no hay más; EMFILE y otros: se reintenta en el próximo evento
+            return;
+        }
+        if (srv->clients >= srv->max_clients || set_nonblocking(fd) != 0) {
+            close(fd);
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // Falla en Unix: no importa
+
+        Connection *c = malloc(sizeof(Connection));
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->game = NULL;
+        c->in_len = 0;
+        c->out_len = 0;
+        c->out_pos = 0;
+        c->events = EPOLLIN;
+        c->closing = 0;
+        c->discarding = 0;
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(srv->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+        srv->clients++;
+        srv->accepted++;
+    }
+}
+
+// Atiende un evento de una conexión
+static void conn_event(Server *srv, Connection *c, unsigned events) {
+    if ((events & EPOLLIN) || (events & (EPOLLHUP | EPOLLERR))) {
+        if (conn_read(c) != 0) {
+            conn_close(srv, c);
+            return;
+        }
+    }
+    conn_process(srv, c);
+    if (conn_flush(c) != 0) {
+        conn_close(srv, c);
+        return;
+    }
+    // Al vaciar la salida pueden quedar comandos que esperaban lugar
+    if (c->in_len > 0 && !c->closing) {
+        conn_process(srv, c);
+        if (conn_flush(c) != 0) {
+            conn_close(srv, c);
+            return;
+        }
+    }
+    if (c->closing && c->out_len == 0) {
+        conn_close(srv, c);
+        return;
+    }
+    conn_update_events(srv, c);
+}
+
+// ============================================================================
+// MODO SERVIDOR
+// ============================================================================
+
+static void server_usage(void) {
+    fprintf(stderr, "Uso: chess serve [--socket RUTA | --tcp PUERTO] [--max-clients N] [--undo N]\n");
+    fprintf(stderr, "  --socket RUTA     Socket Unix (por defecto chess.sock)\n");
+    fprintf(stderr, "  --tcp PUERTO      TCP en 127.0.0.1\n");
+    fprintf(stderr, "  --max-clients N   Conexiones simultáneas (por defecto 16384)\n");
+    fprintf(stderr, "  --undo N          Jugadas que se pueden deshacer por partida (por defecto 32)\n");
+}
+
+int server_mode(int argc, char *argv[]) {
+    const char *socket_path = "chess.sock";
+    int tcp_port = 0;
+    Server srv;
+    memset(&srv, 0, sizeof(srv));
+    srv.undo_depth = 32;
+    srv.max_clients = 16384;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--tcp") == 0 && i + 1 < argc) {
+            tcp_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-clients") == 0 && i + 1 < argc) {
+            srv.max_clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--undo") == 0 && i + 1 < argc) {
+            srv.undo_depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            server_usage();
+            return 0;
+        } else {
+            server_usage();
+            return 2;
+        }
+    }
+    if (srv.max_clients < 1 || srv.undo_depth < 1 || (tcp_port != 0 && (tcp_port < 1 || tcp_port > 65535))) {
+        server_usage();
+        return 2;
+    }
+
+    // Una conexión por partida: se sube el límite de descriptores abiertos
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    srv.listen_fd = tcp_port ? listen_tcp(tcp_port) : listen_unix(socket_path);
+    if (srv.listen_fd < 0) return 2;
+    set_nonblocking(srv.listen_fd);
+
+    srv.epoll_fd = epoll_create1(0);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;   // NULL = socket de escucha
+    if (srv.epoll_fd < 0 || epoll_ctl(srv.epoll_fd, EPOLL_CTL_ADD, srv.listen_fd, &ev) != 0) {
+        perror("epoll");
+        close(srv.listen_fd);
+        return 2;
+    }
+
+    // SIGINT/SIGTERM cortan epoll_wait (sin SA_RESTART) y terminan el bucle
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (tcp_port) {
+        fprintf(stderr, "Escuchando en 127.0.0.1:%d\n", tcp_port);
+    } else {
+        fprintf(stderr, "Escuchando en %s\n", socket_path);
+    }
+
+    struct epoll_event events[EVENT_BATCH];
+    while (!server_stop) {
+        int n = epoll_wait(srv.epoll_fd, events, EVENT_BATCH, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == NULL) {
+                server_accept(&srv);
+            } else {
+                conn_event(&srv, events[i].data.ptr, events[i].events);
+            }
+        }
+    }
+
+    fprintf(stderr, "\n%ld conexiones, %ld comandos, %ld jugadas (%d conexiones abiertas al cerrar)\n",
+            srv.accepted, srv.commands, srv.moves, srv.clients);
+    close(srv.epoll_fd);
+    close(srv.listen_fd);
+    if (!tcp_port) unlink(socket_path);
+    return 0;
+}
+
+#else
+
+int server_mode(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    fprintf(stderr, "El modo servidor necesita epoll (Linux)\n");
+    return 2;
+}
+
+#endif
@@ -0,0 +1,26 @@
+// server.h - Servidor de partidas en vivo (chess serve)
+//
+// Atiende muchas partidas a la vez en un solo proceso: escucha en un socket
+// Unix (o TCP en localhost) y reparte las conexiones con un bucle epoll, sin
+// hilos. Cada conexión lleva una partida (GameSession) y habla un protocolo
+// de líneas de texto; cada comando recibe una línea de respuesta.
+//
+//   NEW [fen]     Empieza una partida (posición inicial o FEN)  -> OK
+//   MOVE <san>    Aplica una jugada                             -> OK <san> <estado>
+//   UNDO          Deshace la última jugada                      -> OK <estado>
+//   FEN           Posición actual                               -> OK <fen>
+//   STATUS        Estado y turno                                -> OK <estado> <white|black>
+//   QUIT          Cierra la conexión                            -> OK
+//
+// Los errores se responden con "ERR <motivo>". Estados: normal, check,
+// checkmate, stalemate, repetition, fifty_move.
+#ifndef SERVER_H
+#define SERVER_H
+
+// Modo servidor de la línea de comandos:
+//   chess serve [--socket RUTA | --tcp PUERTO] [--max-clients N] [--undo N]
+// Corre hasta SIGINT/SIGTERM. Retorna 0 al terminar bien, 2 si no pudo
+// abrir el socket
+int server_mode(int argc, char *argv[]);
+
+#endif // SERVER_H
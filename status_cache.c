@@ -0,0 +1,101 @@
+// status_cache.c - Caché de estados de posición sin bloqueos
+#include <stdatomic.h>
+#include <string.h>
+#include "status_cache.h"
+
+#define STATUS_CACHE_SIZE ((size_t)1 << STATUS_CACHE_BITS)
+
+// Cada entrada es una sola palabra de 64 bits, leída y escrita de forma
+// atómica (sin bloqueos ni lecturas a medias):
+//   bits 0-15   datos
+//     bit 0       entrada válida
+//     bit 1       en jaque
+//     bit 2       tiene jugadas legales
+//     bit 3       cantidad de jugadas conocida
+//     bits 8-15   cantidad de jugadas legales
+//   bits 16-63  bits altos de la clave (verificación)
+#define KEY_MASK  (~(uint64_t)0xFFFF)
+#define DATA_MASK ((uint64_t)0xFFFF)
+
+static _Atomic uint64_t table[STATUS_CACHE_SIZE];
+static atomic_int cache_enabled = 1;
+
+static _Atomic uint64_t total_probes;
+static _Atomic uint64_t total_hits;
+static _Atomic uint64_t total_stores;
+
+// Contadores del hilo: se suman a los globales con status_cache_flush_thread_stats
+static _Thread_local StatusCacheStats local_stats;
+
+static uint64_t pack_status(const CachedStatus *st) {
+    uint64_t d = 1;
+    if (st->in_check)  d |= 2;
+    if (st->has_moves) d |= 4;
+    if (st->legal_moves >= 0 && st->legal_moves < 256) {
+        d |= 8 | ((uint64_t)st->legal_moves << 8);
+    }
+    return d;
+}
+
+static void unpack_status(uint64_t d, CachedStatus *st) {
+    st->in_check = (d & 2) != 0;
+    st->has_moves = (d & 4) != 0;
+    st->legal_moves = (d & 8) ? (int)((d >> 8) & 0xFF) : -1;
+}
+
+int status_cache_probe(uint64_t key, CachedStatus *out) {
+    if (!atomic_load_explicit(&cache_enabled, memory_order_relaxed)) return 0;
+
+    uint64_t entry = atomic_load_explicit(&table[key & (STATUS_CACHE_SIZE - 1)],
+                                          memory_order_relaxed);
+
+    local_stats.probes++;
+    if (((entry ^ key) & KEY_MASK) != 0 || !(entry & 1)) return 0;
+
+    local_stats.hits++;
+    unpack_status(entry & DATA_MASK, out);
+    return 1;
+}
+
+void status_cache_store(uint64_t key, const CachedStatus *st) {
+    if (!atomic_load_explicit(&cache_enabled, memory_order_relaxed)) return;
+
+    atomic_store_explicit(&table[key & (STATUS_CACHE_SIZE - 1)],
+                          (key & KEY_MASK) | pack_status(st), memory_order_relaxed);
+    local_stats.stores++;
+}
+
+void status_cache_prefetch(uint64_t key) {
+    __builtin_prefetch(&table[key & (STATUS_CACHE_SIZE - 1)]);
+}
+
+void status_cache_set_enabled(int enabled) {
+    atomic_store(&cache_enabled, enabled != 0);
+}
+
+int status_cache_enabled(void) {
+    return atomic_load(&cache_enabled);
+}
+
+void status_cache_clear(void) {
+    memset(table, 0, sizeof(table));
+    atomic_store(&total_probes, 0);
+    atomic_store(&total_hits, 0);
+    atomic_store(&total_stores, 0);
+    memset(&local_stats, 0, sizeof(local_stats));
+}
+
+void status_cache_flush_thread_stats(void) {
+    atomic_fetch_add(&total_probes, local_stats.probes);
+    atomic_fetch_add(&total_hits, local_stats.hits);
+    atomic_fetch_add(&total_stores, local_stats.stores);
+    memset(&local_stats, 0, sizeof(local_stats));
+}
+
+StatusCacheStats status_cache_stats(void) {
+    StatusCacheStats s;
+    s.probes = atomic_load(&total_probes) + local_stats.probes;
+    s.hits = atomic_load(&total_hits) + local_stats.hits;
+    s.stores = atomic_load(&total_stores) + local_stats.stores;
+    return s;
+}
@@ -0,0 +1,53 @@
+// status_cache.h - Caché de estados de posición indexada por clave Zobrist
+//
+// Tabla de tamaño fijo, compartida entre hilos y sin bloqueos: cada entrada
+// es una palabra de 64 bits con los bits altos de la clave y el estado, que
+// se lee y escribe de forma atómica. Las colisiones reemplazan la entrada.
+#ifndef STATUS_CACHE_H
+#define STATUS_CACHE_H
+
+#include <stdint.h>
+
+// Entradas de la tabla: 2^STATUS_CACHE_BITS (8 bytes cada una)
+#ifndef STATUS_CACHE_BITS
+#define STATUS_CACHE_BITS 18
+#endif
+
+// Estado guardado de una posición (con turno incluido en la clave)
+typedef struct {
+    int in_check;            // El bando al que le toca está en jaque
+    int has_moves;           // Tiene al menos una jugada legal
+    int legal_moves;         // Cantidad de jugadas legales, -1 = no calculada
+} CachedStatus;
+
+// Estadísticas de uso
+typedef struct {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+} StatusCacheStats;
+
+// 1 si la clave está en la caché (y la copia en 'out')
+int status_cache_probe(uint64_t key, CachedStatus *out);
+
+// Guarda (o reemplaza) el estado de la clave
+void status_cache_store(uint64_t key, const CachedStatus *st);
+
+// Adelanta la carga de la entrada de la clave (antes de consultarla)
+void status_cache_prefetch(uint64_t key);
+
+// Activa o desactiva la caché (activa por defecto)
+void status_cache_set_enabled(int enabled);
+int status_cache_enabled(void);
+
+// Vacía la tabla y las estadísticas (no llamar con otros hilos usándola)
+void status_cache_clear(void);
+
+// Los contadores se llevan por hilo; un hilo que termina debe sumarlos a
+// los globales antes de salir
+void status_cache_flush_thread_stats(void);
+
+// Estadísticas acumuladas (globales + las del hilo que llama)
+StatusCacheStats status_cache_stats(void);
+
+#endif // STATUS_CACHE_H
@@ -0,0 +1,523 @@
+// tag_index.c - Almacén de etiquetas internadas e índices de búsqueda
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <strings.h>
+#include "tag_index.h"
+
+static void *grow(void *ptr, size_t size) {
+    void *p = realloc(ptr, size);
+    if (!p) { perror("realloc"); exit(EXIT_FAILURE); }
+    return p;
+}
+
+// ============================================================================
+// CADENAS INTERNADAS
+// ============================================================================
+
+static uint32_t hash_bytes(const char *s, size_t len) {
+    uint32_t h = 2166136261u;                // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int atom_equals(const TagIndex *t, TagAtom a, const char *s, size_t len) {
+    const char *str = t->pool + t->offsets[a];
+    return strncmp(str, s, len) == 0 && str[len] == '\0';
+}
+
+// Duplica la tabla hash y reubica los átomos
+static void rehash(TagIndex *t) {
+    uint32_t size = t->slot_mask ? (t->slot_mask + 1) * 2 : 1024;
+    free(t->slots);
+    t->slots = calloc(size, sizeof(uint32_t));
+    if (!t->slots) { perror("calloc"); exit(EXIT_FAILURE); }
+    t->slot_mask = size - 1;
+
+    for (int a = 1; a < t->atom_count; a++) {
+        const char *s = t->pool + t->offsets[a];
+        uint32_t i = hash_bytes(s, strlen(s)) & t->slot_mask;
+        while (t->slots[i]) i = (i + 1) & t->slot_mask;
+        t->slots[i] = (uint32_t)a;
+    }
+}
+
+// Busca la cadena; si no está y 'insert', la agrega
+static TagAtom intern(TagIndex *t, const char *s, size_t len, int insert) {
+    if (len == 0) return 0;
+
+    uint32_t i = hash_bytes(s, len) & t->slot_mask;
+    while (t->slots[i]) {
+        if (atom_equals(t, t->slots[i], s, len)) return t->slots[i];
+        i = (i + 1) & t->slot_mask;
+    }
+    if (!insert) return 0;
+
+    if (t->pool_len + len + 1 > t->pool_cap) {
+        size_t cap = t->pool_cap * 2;
+        while (cap < t->pool_len + len + 1) cap *= 2;
+        t->pool = grow(t->pool, cap);
+        t->pool_cap = cap;
+    }
+    if (t->atom_count >= t->atom_capacity) {
+        t->atom_capacity *= 2;
+        t->offsets = grow(t->offsets, sizeof(uint32_t) * (size_t)t->atom_capacity);
+    }
+
+    TagAtom a = (TagAtom)t->atom_count++;
+    t->offsets[a] = (uint32_t)t->pool_len;
+    memcpy(t->pool + t->pool_len, s, len);
+    t->pool[t->pool_len + len] = '\0';
+    t->pool_len += len + 1;
+    t->slots[i] = a;
+
+    // Carga máxima de la tabla: 1/2
+    if ((uint32_t)t->atom_count * 2 > t->slot_mask) rehash(t);
+    return a;
+}
+
+TagAtom tag_index_find(const TagIndex *t, const char *s) {
+    return intern((TagIndex *)t, s, strlen(s), 0);
+}
+
+const char *tag_index_string(const TagIndex *t, TagAtom a) {
+    return t->pool + t->offsets[a];
+}
+
+// ============================================================================
+// ALMACÉN DE ETIQUETAS
+// ============================================================================
+
+void tag_index_init(TagIndex *t) {
+    memset(t, 0, sizeof(*t));
+    t->pool_cap = 4096;
+    t->pool = grow(NULL, t->pool_cap);
+    t->pool[0] = '\0';                       // Átomo 0 = ""
+    t->pool_len = 1;
+    t->atom_capacity = 256;
+    t->offsets = grow(NULL, sizeof(uint32_t) * (size_t)t->atom_capacity);
+    t->offsets[0] = 0;
+    t->atom_count = 1;
+    rehash(t);
+    t->first = grow(NULL, sizeof(uint32_t));
+    t->first[0] = 0;
+}
+
+static void free_postings(TagPostings *p) {
+    free(p->start);
+    free(p->games);
+    p->start = NULL;
+    p->games = NULL;
+}
+
+static void free_sorted(TagSortedColumn *c) {
+    free(c->games);
+    c->games = NULL;
+    c->count = 0;
+}
+
+void tag_index_free(TagIndex *t) {
+    free(t->pool);
+    free(t->offsets);
+    free(t->slots);
+    free(t->pairs);
+    free(t->first);
+    free(t->white);
+    free(t->black);
+    free(t->eco);
+    free(t->white_elo);
+    free(t->black_elo);
+    free(t->date);
+    free_postings(&t->players);
+    free_postings(&t->ecos);
+    free_sorted(&t->by_white_elo);
+    free_sorted(&t->by_black_elo);
+    free_sorted(&t->by_date);
+    memset(t, 0, sizeof(*t));
+}
+
+static int view_is(PGNView v, const char *key) {
+    size_t n = strlen(key);
+    return v.len == n && memcmp(v.ptr, key, n) == 0;
+}
+
+// Elo de la etiqueta (solo dígitos), 0 si no es un número
+static int parse_elo(PGNView v) {
+    int elo = 0;
+    if (v.len == 0 || v.len > 4) return 0;
+    for (size_t i = 0; i < v.len; i++) {
+        if (!isdigit((unsigned char)v.ptr[i])) return 0;
+        elo = elo * 10 + (v.ptr[i] - '0');
+    }
+    return elo;
+}
+
+int tag_parse_date(const char *s, size_t len, int upper) {
+    // Año, mes y día; los que faltan o son "??" quedan en 0 (o en el máximo)
+    static const int widths[3] = { 4, 2, 2 };
+    static const int maxima[3] = { 0, 12, 31 };
+    int parts[3] = { 0, 0, 0 };
+    size_t p = 0;
+
+    for (int k = 0; k < 3; k++) {
+        if (k > 0) {
+            if (p == len) {
+                parts[k] = upper ? maxima[k] : 0;
+                continue;
+            }
+            if (s[p] != '.') return 0;
+            p++;
+        }
+        if (p + (size_t)widths[k] > len) return 0;
+
+        int value = 0, unknown = 0;
+        for (int i = 0; i < widths[k]; i++) {
+            char c = s[p + (size_t)i];
+            if (c == '?') unknown = 1;
+            else if (isdigit((unsigned char)c)) value = value * 10 + (c - '0');
+            else return 0;
+        }
+        p += (size_t)widths[k];
+        if (unknown) {
+            if (k == 0) return 0;            // Sin año no hay fecha
+            value = upper ? maxima[k] : 0;
+        }
+        parts[k] = value;
+    }
+    if (p != len || parts[0] == 0) return 0;
+    return parts[0] * 10000 + parts[1] * 100 + parts[2];
+}
+
+int tag_index_add_game(TagIndex *t, PGNView tags) {
+    if (t->games + 1 >= t->game_capacity) {
+        int cap = t->game_capacity ? t->game_capacity * 2 : 1024;
+        t->first     = grow(t->first, sizeof(uint32_t) * ((size_t)cap + 1));
+        t->white     = grow(t->white, sizeof(TagAtom) * (size_t)cap);
+        t->black     = grow(t->black, sizeof(TagAtom) * (size_t)cap);
+        t->eco       = grow(t->eco, sizeof(TagAtom) * (size_t)cap);
+        t->white_elo = grow(t->white_elo, sizeof(int) * (size_t)cap);
+        t->black_elo = grow(t->black_elo, sizeof(int) * (size_t)cap);
+        t->date      = grow(t->date, sizeof(int) * (size_t)cap);
+        t->game_capacity = cap;
+    }
+
+    int g = t->games++;
+    t->white[g] = t->black[g] = t->eco[g] = 0;
+    t->white_elo[g] = t->black_elo[g] = t->date[g] = 0;
+
+    PGNView name, value;
+    while (pgn_next_tag(&tags, &name, &value)) {
+        if (name.len == 0) continue;
+        if (t->pair_count >= t->pair_capacity) {
+            t->pair_capacity = t->pair_capacity ? t->pair_capacity * 2 : 4096;
+            t->pairs = grow(t->pairs, sizeof(TagPair) * t->pair_capacity);
+        }
+        TagPair *pair = &t->pairs[t->pair_count++];
+        pair->name = intern(t, name.ptr, name.len, 1);
+        pair->value = intern(t, value.ptr, value.len, 1);
+
+        if (view_is(name, "White"))         t->white[g] = pair->value;
+        else if (view_is(name, "Black"))    t->black[g] = pair->value;
+        else if (view_is(name, "ECO"))      t->eco[g] = pair->value;
+        else if (view_is(name, "WhiteElo")) t->white_elo[g] = parse_elo(value);
+        else if (view_is(name, "BlackElo")) t->black_elo[g] = parse_elo(value);
+        else if (view_is(name, "Date"))     t->date[g] = tag_parse_date(value.ptr, value.len, 0);
+    }
+    t->first[g + 1] = (uint32_t)t->pair_count;
+    return g;
+}
+
+const char *tag_index_get(const TagIndex *t, int game, const char *name) {
+    TagAtom a = tag_index_find(t, name);
+    if (!a) return NULL;
+    for (uint32_t i = t->first[game]; i < t->first[game + 1]; i++) {
+        if (t->pairs[i].name == a) return tag_index_string(t, t->pairs[i].value);
+    }
+    return NULL;
+}
+
+size_t tag_index_format(const TagIndex *t, int game, char *out, size_t out_size) {
+    size_t len = 0;
+    for (uint32_t i = t->first[game]; i < t->first[game + 1]; i++) {
+        int n = snprintf(len < out_size ? out + len : NULL, len < out_size ? out_size - len : 0,
+                         "[%s \"%s\"]\n", tag_index_string(t, t->pairs[i].name),
+                         tag_index_string(t, t->pairs[i].value));
+        if (n > 0) len += (size_t)n;
+    }
+    if (out_size > 0 && len < out_size) out[len] = '\0';
+    return len;
+}
+
+// ============================================================================
+// ÍNDICES SECUNDARIOS
+// ============================================================================
+
+// Índice invertido de una o dos columnas de átomos (counting sort: las
+// partidas de cada átomo quedan en orden)
+static void build_postings(TagPostings *p, int atoms, int games,
+                           const TagAtom *a, const TagAtom *b) {
+    free_postings(p);
+    p->start = calloc((size_t)atoms + 1, sizeof(int));
+    if (!p->start) { perror("calloc"); exit(EXIT_FAILURE); }
+
+    for (int g = 0; g < games; g++) {
+        if (a[g]) p->start[a[g] + 1]++;
+        if (b && b[g] && b[g] != a[g]) p->start[b[g] + 1]++;
+    }
+    for (int i = 0; i < atoms; i++) p->start[i + 1] += p->start[i];
+
+    p->games = grow(NULL, sizeof(int) * ((size_t)p->start[atoms] + 1));
+    int *fill = grow(NULL, sizeof(int) * (size_t)atoms);
+    memcpy(fill, p->start, sizeof(int) * (size_t)atoms);
+    for (int g = 0; g < games; g++) {
+        if (a[g]) p->games[fill[a[g]]++] = g;
+        if (b && b[g] && b[g] != a[g]) p->games[fill[b[g]]++] = g;
+    }
+    free(fill);
+}
+
+static const int *sort_keys;
+
+static int compare_by_key(const void *x, const void *y) {
+    int a = *(const int *)x, b = *(const int *)y;
+    if (sort_keys[a] != sort_keys[b]) return sort_keys[a] < sort_keys[b] ? -1 : 1;
+    return (a > b) - (a < b);
+}
+
+// Partidas con valor conocido ordenadas por 'keys'
+static void build_sorted(TagSortedColumn *c, const int *keys, int games) {
+    free_sorted(c);
+    c->games = grow(NULL, sizeof(int) * ((size_t)games + 1));
+    for (int g = 0; g < games; g++) {
+        if (keys[g]) c->games[c->count++] = g;
+    }
+    sort_keys = keys;
+    qsort(c->games, (size_t)c->count, sizeof(int), compare_by_key);
+}
+
+static void build_indexes(TagIndex *t) {
+    if (t->built_games == t->games) return;
+    build_postings(&t->players, t->atom_count, t->games, t->white, t->black);
+    build_postings(&t->ecos, t->atom_count, t->games, t->eco, NULL);
+    build_sorted(&t->by_white_elo, t->white_elo, t->games);
+    build_sorted(&t->by_black_elo, t->black_elo, t->games);
+    build_sorted(&t->by_date, t->date, t->games);
+    t->built_games = t->games;
+}
+
+// Primera posición de la columna con valor >= key
+static int lower_bound(const TagSortedColumn *c, const int *keys, int key) {
+    int lo = 0, hi = c->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (keys[c->games[mid]] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// ============================================================================
+// CONSULTAS
+// ============================================================================
+
+// Candidatos de la consulta: la lista más corta entre las que da cada índice
+typedef struct {
+    const int *games;
+    int count;
+    int sorted;              // 1 = en orden de partida
+} Candidates;
+
+static void consider(Candidates *c, const int *games, int count, int sorted) {
+    if (count < c->count) {
+        c->games = games;
+        c->count = count;
+        c->sorted = sorted;
+    }
+}
+
+static int consider_postings(Candidates *c, const TagPostings *p, TagAtom a) {
+    if (!a) return 0;
+    consider(c, p->games + p->start[a], p->start[a + 1] - p->start[a], 1);
+    return 1;
+}
+
+static void consider_range(Candidates *c, const TagSortedColumn *col, const int *keys,
+                           int min, int max) {
+    if (!min && !max) return;
+    int lo = min ? lower_bound(col, keys, min) : 0;
+    int hi = max ? lower_bound(col, keys, max + 1) : col->count;
+    consider(c, col->games + lo, hi > lo ? hi - lo : 0, 0);
+}
+
+static int in_range(int value, int min, int max) {
+    if (!min && !max) return 1;
+    if (!value) return 0;
+    return (!min || value >= min) && (!max || value <= max);
+}
+
+static int compare_int(const void *x, const void *y) {
+    int a = *(const int *)x, b = *(const int *)y;
+    return (a > b) - (a < b);
+}
+
+int tag_index_query(TagIndex *t, const TagQuery *q, int *out) {
+    build_indexes(t);
+
+    // Las cadenas que no aparecen en ninguna partida no tienen resultados
+    TagAtom player = 0, white = 0, black = 0, eco = 0, name = 0, value = 0;
+    if ((q->player && !(player = tag_index_find(t, q->player))) ||
+        (q->white && !(white = tag_index_find(t, q->white))) ||
+        (q->black && !(black = tag_index_find(t, q->black))) ||
+        (q->eco && !(eco = tag_index_find(t, q->eco))) ||
+        (q->tag_name && !(name = tag_index_find(t, q->tag_name))) ||
+        (q->tag_value && !(value = tag_index_find(t, q->tag_value)))) {
+        return 0;
+    }
+
+    Candidates c = { NULL, t->games + 1, 1 };
+    consider_postings(&c, &t->players, player);
+    consider_postings(&c, &t->players, white);
+    consider_postings(&c, &t->players, black);
+    consider_postings(&c, &t->ecos, eco);
+    consider_range(&c, &t->by_white_elo, t->white_elo, q->white_elo_min, q->white_elo_max);
+    consider_range(&c, &t->by_black_elo, t->black_elo, q->black_elo_min, q->black_elo_max);
+    consider_range(&c, &t->by_date, t->date, q->date_min, q->date_max);
+
+    int count = 0;
+    int total = c.games ? c.count : t->games;
+    for (int i = 0; i < total; i++) {
+        int g = c.games ? c.games[i] : i;
+
+        if (player && t->white[g] != player && t->black[g] != player) continue;
+        if (white && t->white[g] != white) continue;
+        if (black && t->black[g] != black) continue;
+        if (eco && t->eco[g] != eco) continue;
+        if (!in_range(t->white_elo[g], q->white_elo_min, q->white_elo_max)) continue;
+        if (!in_range(t->black_elo[g], q->black_elo_min, q->black_elo_max)) continue;
+        if (!in_range(t->date[g], q->date_min, q->date_max)) continue;
+        if (name) {
+            uint32_t k = t->first[g];
+            while (k < t->first[g + 1] && t->pairs[k].name != name) k++;
+            if (k == t->first[g + 1] || (value && t->pairs[k].value != value)) continue;
+        }
+        out[count++] = g;
+    }
+
+    if (!c.sorted) qsort(out, (size_t)count, sizeof(int), compare_int);
+    return count;
+}
+
+// ============================================================================
+// LECTURA DE CONSULTAS
+// ============================================================================
+
+// Límites de un valor numérico según el operador
+static int set_bound(const char *op, int value, int *min, int *max) {
+    if (strcmp(op, "=") == 0)       { *min = value; *max = value; }
+    else if (strcmp(op, ">=") == 0) { *min = value; }
+    else if (strcmp(op, ">") == 0)  { *min = value + 1; }
+    else if (strcmp(op, "<=") == 0) { *max = value; }
+    else if (strcmp(op, "<") == 0)  { *max = value - 1; }
+    else return -1;
+    return 0;
+}
+
+int tag_query_parse(TagQuery *q, char *text, char *err, size_t err_size) {
+    memset(q, 0, sizeof(*q));
+    char *p = text;
+
+    while (1) {
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+
+        // Clave hasta el operador
+        char *key = p;
+        while (*p && (isalnum((unsigned char)*p) || *p == '_')) p++;
+        if (p == key) {
+            snprintf(err, err_size, "se esperaba una clave en '%s'", key);
+            return -1;
+        }
+        char *key_end = p;
+        char op[3] = { 0, 0, 0 };
+        if (*p == '=' || *p == '<' || *p == '>') {
+            op[0] = *p++;
+            if (op[0] != '=' && *p == '=') op[1] = *p++;
+        } else {
+            snprintf(err, err_size, "falta el operador después de '%.*s'",
+                     (int)(key_end - key), key);
+            return -1;
+        }
+
+        // Valor: hasta el siguiente espacio, o entre comillas
+        char *value;
+        if (*p == '"') {
+            value = ++p;
+            while (*p && *p != '"') p++;
+            if (!*p) {
+                snprintf(err, err_size, "falta la comilla de cierre");
+                return -1;
+            }
+        } else {
+            value = p;
+            while (*p && !isspace((unsigned char)*p)) p++;
+        }
+        char *value_end = p;
+        if (*p) p++;
+        *key_end = '\0';
+        *value_end = '\0';
+
+        int numeric = (strcasecmp(key, "whiteelo") == 0 || strcasecmp(key, "blackelo") == 0 ||
+                       strcasecmp(key, "elo") == 0 || strcasecmp(key, "date") == 0);
+        if (!numeric && strcmp(op, "=") != 0) {
+            snprintf(err, err_size, "'%s' solo admite '='", key);
+            return -1;
+        }
+
+        if (strcasecmp(key, "player") == 0) {
+            q->player = value;
+        } else if (strcasecmp(key, "white") == 0) {
+            q->white = value;
+        } else if (strcasecmp(key, "black") == 0) {
+            q->black = value;
+        } else if (strcasecmp(key, "eco") == 0) {
+            q->eco = value;
+        } else if (strcasecmp(key, "date") == 0) {
+            // Con '=' una fecha incompleta abarca el año o el mes entero
+            int lo = tag_parse_date(value, strlen(value), 0);
+            int hi = tag_parse_date(value, strlen(value), 1);
+            if (!lo) {
+                snprintf(err, err_size, "fecha inválida: '%s'", value);
+                return -1;
+            }
+            if (op[0] == '=') { q->date_min = lo; q->date_max = hi; }
+            else if (op[0] == '>') set_bound(op, op[1] ? lo : hi, &q->date_min, &q->date_max);
+            else set_bound(op, op[1] ? hi : lo, &q->date_min, &q->date_max);
+        } else if (numeric) {
+            char *end;
+            long elo = strtol(value, &end, 10);
+            if (*value == '\0' || *end != '\0' || elo <= 0 || elo > 9999) {
+                snprintf(err, err_size, "Elo inválido: '%s'", value);
+                return -1;
+            }
+            int both = (strcasecmp(key, "elo") == 0);
+            if (both || strcasecmp(key, "whiteelo") == 0) {
+                set_bound(op, (int)elo, &q->white_elo_min, &q->white_elo_max);
+            }
+            if (both || strcasecmp(key, "blackelo") == 0) {
+                set_bound(op, (int)elo, &q->black_elo_min, &q->black_elo_max);
+            }
+        } else {
+            if (q->tag_name) {
+                snprintf(err, err_size, "solo se admite una etiqueta más además de las conocidas");
+                return -1;
+            }
+            q->tag_name = key;
+            q->tag_value = value[0] ? value : NULL;
+        }
+    }
+    return 0;
+}
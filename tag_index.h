@@ -0,0 +1,119 @@
+// tag_index.h - Etiquetas de las partidas de una colección e índices
+//
+// Guarda todas las etiquetas de cada partida ([Date], [ECO], [WhiteElo],
+// ...) como pares (nombre, valor) de cadenas internadas: cada cadena
+// distinta se guarda una sola vez y las partidas la referencian con un
+// número (átomo). Sobre ellas se arman índices secundarios (jugador ->
+// partidas, ECO -> partidas, partidas ordenadas por Elo y por fecha), así
+// las búsquedas por etiquetas no vuelven a leer el texto de las jugadas.
+#ifndef TAG_INDEX_H
+#define TAG_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pgn_reader.h"
+
+// Cadena internada; 0 = ninguna (etiqueta ausente o vacía)
+typedef uint32_t TagAtom;
+
+typedef struct {
+    TagAtom name;
+    TagAtom value;
+} TagPair;
+
+// Partidas ordenadas por un valor numérico (Elo o fecha)
+typedef struct {
+    int *games;              // Partidas con el valor conocido, de menor a mayor
+    int count;
+} TagSortedColumn;
+
+// Listas de partidas por átomo (índice invertido)
+typedef struct {
+    int *start;              // Partidas del átomo a: games[start[a] .. start[a + 1])
+    int *games;
+} TagPostings;
+
+typedef struct {
+    // Cadenas internadas: la cadena del átomo a empieza en pool + offsets[a]
+    char *pool;
+    size_t pool_len;
+    size_t pool_cap;
+    uint32_t *offsets;
+    int atom_count;          // Incluye el átomo 0 ("")
+    int atom_capacity;
+    uint32_t *slots;         // Tabla hash de átomos (0 = libre)
+    uint32_t slot_mask;
+
+    // Etiquetas de cada partida: pairs[first[g] .. first[g + 1])
+    TagPair *pairs;
+    size_t pair_count;
+    size_t pair_capacity;
+    uint32_t *first;
+    int games;
+    int game_capacity;
+
+    // Columnas de consulta (una entrada por partida)
+    TagAtom *white;
+    TagAtom *black;
+    TagAtom *eco;
+    int *white_elo;          // 0 = desconocido
+    int *black_elo;
+    int *date;               // AAAAMMDD ("??" = 00), 0 = desconocida
+
+    // Índices secundarios; se rearman en la primera consulta tras agregar
+    // partidas (built_games = partidas que cubren)
+    int built_games;
+    TagPostings players;     // Blancas o negras
+    TagPostings ecos;
+    TagSortedColumn by_white_elo;
+    TagSortedColumn by_black_elo;
+    TagSortedColumn by_date;
+} TagIndex;
+
+// Consulta: se combinan todas las condiciones dadas (NULL / 0 = sin condición)
+typedef struct {
+    const char *player;      // Blancas o negras (nombre exacto, como en la etiqueta)
+    const char *white;
+    const char *black;
+    const char *eco;
+    int white_elo_min, white_elo_max;
+    int black_elo_min, black_elo_max;
+    int date_min, date_max;  // AAAAMMDD
+    const char *tag_name;    // Cualquier otra etiqueta: [tag_name "tag_value"]
+    const char *tag_value;
+} TagQuery;
+
+void tag_index_init(TagIndex *t);
+void tag_index_free(TagIndex *t);
+
+// Agrega una partida con sus líneas de etiquetas; devuelve su número (desde 0)
+int tag_index_add_game(TagIndex *t, PGNView tags);
+
+// Átomo de una cadena ya internada, o 0 si no aparece en ninguna partida
+TagAtom tag_index_find(const TagIndex *t, const char *s);
+
+// Cadena de un átomo
+const char *tag_index_string(const TagIndex *t, TagAtom a);
+
+// Valor de la etiqueta 'name' en la partida 'game', o NULL si no la tiene
+const char *tag_index_get(const TagIndex *t, int game, const char *name);
+
+// Escribe las etiquetas de la partida como líneas [Nombre "Valor"].
+// Devuelve la longitud (sin el '\0'), o la necesaria si no cabe en 'out'
+size_t tag_index_format(const TagIndex *t, int game, char *out, size_t out_size);
+
+// Fecha "AAAA.MM.DD" (se aceptan "??" y fechas incompletas) como AAAAMMDD;
+// con 'upper' las partes que faltan cuentan como el máximo. 0 = inválida
+int tag_parse_date(const char *s, size_t len, int upper);
+
+// Lee una consulta "clave=valor ..." (claves: player, white, black, eco,
+// whiteelo, blackelo, elo, date o el nombre de cualquier etiqueta; Elo y
+// fecha admiten >, >=, <, <=; los valores con espacios van entre comillas).
+// Modifica 'text': las cadenas de 'q' apuntan a él. 0 = éxito, -1 = error
+int tag_query_parse(TagQuery *q, char *text, char *err, size_t err_size);
+
+// Partidas que cumplen la consulta, en orden. 'out' debe tener lugar para
+// todas las partidas del índice. Devuelve cuántas hay
+int tag_index_query(TagIndex *t, const TagQuery *q, int *out);
+
+#endif // TAG_INDEX_H
@@ -0,0 +1,71 @@
+// test_history.c - Pruebas de repetición y regla de 50 desde posiciones FEN
+//
+// Una partida desde FEN puede empezar con un reloj de la regla de 50 mayor
+// que las posiciones registradas en el historial; la búsqueda de
+// repeticiones no debe salirse del historial.
+//
+// Compilar (con -fsanitize=address para detectar lecturas fuera de rango):
+//   gcc -g -fsanitize=address -o test_history test_history.c semant.c attacks.c zobrist.c lexer.c parser.c status_cache.c -pthread
+// Ejecutar:
+//   ./test_history
+#include <stdio.h>
+#include <string.h>
+#include "ast.h"
+#include "parser.h"
+#include "semant.h"
+
+static int failures = 0;
+
+static void check(int cond, const char *what) {
+    printf("%s %s\n", cond ? "OK   " : "FALLA", what);
+    if (!cond) failures++;
+}
+
+// Aplica una jugada SAN y la registra en el historial; 0 = aplicada
+static int play(Board *b, PositionHistory *h, Color *side, const char *san) {
+    MoveAST ast;
+    char err[256];
+    if (san_parse(san, strlen(san), &ast) != 0) return -1;
+    if (board_apply_move(b, &ast, *side, err, sizeof(err)) != 0) return -1;
+    history_push(h, b);
+    *side = (*side == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    return 0;
+}
+
+int main(void) {
+    Board b;
+    Color side;
+    int halfmove, fullmove;
+    PositionHistory h;
+
+    // Reloj de 60 medias jugadas con una sola posición registrada
+    int rc = board_from_fen(&b, "8/8/8/8/8/8/k7/2K5 w - - 60 40", &side, &halfmove, &fullmove);
+    check(rc == 0 && halfmove == 60, "FEN con reloj de 60 medias jugadas");
+    history_init(&h, &b);
+    h.halfmove_clock = halfmove;
+    check(history_repetitions(&h) == 1, "posición inicial: 1 repetición");
+    check(history_evaluate_status(&h, &b, side) == POSITION_NORMAL, "posición inicial: estado normal");
+
+    // Los reyes van y vuelven: la posición inicial se repite tres veces
+    static const char *moves[] = { "Kd2", "Ka3", "Kc1", "Ka2", "Kd2", "Ka3", "Kc1", "Ka2" };
+    int played = 0;
+    for (int i = 0; i < 8; i++) {
+        if (play(&b, &h, &side, moves[i]) != 0) break;
+        played++;
+        if (i == 3) check(history_repetitions(&h) == 2, "tras 4 medias jugadas: 2 repeticiones");
+    }
+    check(played == 8, "8 medias jugadas aplicadas");
+    check(history_repetitions(&h) == 3, "tras 8 medias jugadas: 3 repeticiones");
+    check(history_evaluate_status(&h, &b, side) == POSITION_DRAW_REPETITION, "tablas por repetición");
+
+    // Reloj a 99: una jugada más de rey cumple la regla de 50
+    rc = board_from_fen(&b, "8/8/8/8/8/8/k7/2K5 w - - 99 80", &side, &halfmove, &fullmove);
+    history_init(&h, &b);
+    h.halfmove_clock = halfmove;
+    check(rc == 0 && history_repetitions(&h) == 1, "reloj de 99: 1 repetición");
+    check(play(&b, &h, &side, "Kd1") == 0 &&
+          history_evaluate_status(&h, &b, side) == POSITION_DRAW_FIFTY_MOVE, "tablas por la regla de 50");
+
+    printf("%s\n", failures ? "Hay pruebas fallidas" : "Todas las pruebas pasaron");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,364 @@
+// validate.c - Validación de partidas PGN con salida para máquinas
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+#include "semant.h"
+#include "pgn.h"
+#include "pgn_reader.h"
+
+typedef enum {
+    FORMAT_JSONL,
+    FORMAT_TSV
+} OutputFormat;
+
+// ============================================================================
+// BÚFER DE SALIDA
+// ============================================================================
+
+// Se escribe al archivo cada OUT_FLUSH_SIZE bytes
+#define OUT_FLUSH_SIZE (64 * 1024)
+
+typedef struct {
+    FILE *f;
+    char data[OUT_FLUSH_SIZE + 1024];
+    size_t len;
+} OutBuffer;
+
+static void out_flush(OutBuffer *o) {
+    if (o->len) fwrite(o->data, 1, o->len, o->f);
+    o->len = 0;
+}
+
+static void out_bytes(OutBuffer *o, const char *s, size_t n) {
+    if (o->len + n > sizeof(o->data)) {
+        out_flush(o);
+        if (n > sizeof(o->data)) {
+            fwrite(s, 1, n, o->f);
+            return;
+        }
+    }
+    memcpy(o->data + o->len, s, n);
+    o->len += n;
+}
+
+static void out_str(OutBuffer *o, const char *s) {
+    out_bytes(o, s, strlen(s));
+}
+
+static void out_char(OutBuffer *o, char c) {
+    if (o->len + 1 > sizeof(o->data)) out_flush(o);
+    o->data[o->len++] = c;
+}
+
+static void out_long(OutBuffer *o, long v) {
+    char tmp[24];
+    int n = snprintf(tmp, sizeof(tmp), "%ld", v);
+    out_bytes(o, tmp, (size_t)n);
+}
+
+// Cadena JSON entre comillas (con escapes de comillas, barras y controles)
+static void out_json(OutBuffer *o, const char *s, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    out_char(o, '"');
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\') {
+            out_char(o, '\\');
+            out_char(o, (char)c);
+        } else if (c == '\n') {
+            out_str(o, "\\n");
+        } else if (c == '\t') {
+            out_str(o, "\\t");
+        } else if (c < 0x20) {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+            out_bytes(o, esc, sizeof(esc));
+        } else {
+            out_char(o, (char)c);
+        }
+    }
+    out_char(o, '"');
+}
+
+// Campo TSV: los tabuladores y saltos de línea se cambian por espacios
+static void out_tsv(OutBuffer *o, const char *s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        char c = s[i];
+        out_char(o, (c == '\t' || c == '\n' || c == '\r') ? ' ' : c);
+    }
+}
+
+// ============================================================================
+// REGISTROS
+// ============================================================================
+
+static const char *error_kind_name(PGNErrorKind kind) {
+    switch (kind) {
+        case PGN_ERROR_FEN:      return "fen";
+        case PGN_ERROR_LEXICAL:  return "lexical";
+        case PGN_ERROR_SYNTAX:   return "syntax";
+        case PGN_ERROR_SEMANTIC: return "semantic";
+        case PGN_ERROR_EMPTY:    return "empty";
+        default:                 return "";
+    }
+}
+
+static const char *final_status_name(PositionStatus st) {
+    switch (st) {
+        case POSITION_CHECK:           return "check";
+        case POSITION_CHECKMATE:       return "checkmate";
+        case POSITION_STALEMATE:       return "stalemate";
+        case POSITION_DRAW_REPETITION: return "repetition";
+        case POSITION_DRAW_FIFTY_MOVE: return "fifty_move";
+        default:                       return "normal";
+    }
+}
+
+// Datos de una partida validada
+typedef struct {
+    const char *file;
+    long game;               // Número de la partida en el archivo (desde 1)
+    long offset;             // Posición de su [Event ...] en el archivo
+    const PGNGame *g;
+    int ok;
+    const PGNGameError *err;
+} GameReport;
+
+static void write_jsonl(OutBuffer *o, const GameReport *r) {
+    const PGNGame *g = r->g;
+    out_str(o, "{\"file\":");
+    out_json(o, r->file, strlen(r->file));
+    out_str(o, ",\"game\":");
+    out_long(o, r->game);
+    out_str(o, ",\"offset\":");
+    out_long(o, r->offset);
+    out_str(o, ",\"white\":");
+    out_json(o, g->white, strlen(g->white));
+    out_str(o, ",\"black\":");
+    out_json(o, g->black, strlen(g->black));
+    out_str(o, ",\"result\":");
+    out_json(o, g->result, strlen(g->result));
+
+    if (r->ok) {
+        out_str(o, ",\"status\":\"valid\",\"plies\":");
+        out_long(o, g->move_count);
+        out_str(o, ",\"final\":\"");
+        out_str(o, final_status_name(g->final_status));
+        out_char(o, '"');
+        const char *expected = pgn_game_expected_result(g);
+        if (expected) {
+            out_str(o, ",\"expected_result\":\"");
+            out_str(o, expected);
+            out_char(o, '"');
+        }
+    } else {
+        const PGNGameError *e = r->err;
+        out_str(o, ",\"status\":\"invalid\",\"plies\":");
+        out_long(o, e->ply > 0 ? e->ply - 1 : 0);
+        out_str(o, ",\"error\":\"");
+        out_str(o, error_kind_name(e->kind));
+        out_str(o, "\",\"ply\":");
+        out_long(o, e->ply);
+        out_str(o, ",\"move\":");
+        out_json(o, e->move.ptr ? e->move.ptr : "", e->move.len);
+        out_str(o, ",\"reason\":");
+        out_json(o, e->reason, strlen(e->reason));
+    }
+    out_str(o, "}\n");
+}
+
+static const char *tsv_header =
+    "file\tgame\toffset\tstatus\tplies\tfinal\texpected_result\terror\tply\tmove\treason"
+    "\twhite\tblack\tresult\n";
+
+static void write_tsv(OutBuffer *o, const GameReport *r) {
+    const PGNGame *g = r->g;
+    const PGNGameError *e = r->err;
+    out_tsv(o, r->file, strlen(r->file));
+    out_char(o, '\t');
+    out_long(o, r->game);
+    out_char(o, '\t');
+    out_long(o, r->offset);
+    out_char(o, '\t');
+
+    if (r->ok) {
+        const char *expected = pgn_game_expected_result(g);
+        out_str(o, "valid\t");
+        out_long(o, g->move_count);
+        out_char(o, '\t');
+        out_str(o, final_status_name(g->final_status));
+        out_char(o, '\t');
+        out_str(o, expected ? expected : "");
+        out_str(o, "\t\t0\t\t");
+    } else {
+        out_str(o, "invalid\t");
+        out_long(o, e->ply > 0 ? e->ply - 1 : 0);
+        out_str(o, "\t\t\t");
+        out_str(o, error_kind_name(e->kind));
+        out_char(o, '\t');
+        out_long(o, e->ply);
+        out_char(o, '\t');
+        out_tsv(o, e->move.ptr ? e->move.ptr : "", e->move.len);
+        out_char(o, '\t');
+        out_tsv(o, e->reason, strlen(e->reason));
+    }
+    out_char(o, '\t');
+    out_tsv(o, g->white, strlen(g->white));
+    out_char(o, '\t');
+    out_tsv(o, g->black, strlen(g->black));
+    out_char(o, '\t');
+    out_tsv(o, g->result, strlen(g->result));
+    out_char(o, '\n');
+}
+
+// ============================================================================
+// MODO VALIDATE
+// ============================================================================
+
+typedef struct {
+    long games;
+    long valid;
+    long invalid;
+    long plies;
+} ValidateTotals;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 1 si el archivo es regular (no una tubería, FIFO o terminal)
+static int is_regular_file(FILE *f) {
+#if !defined(_WIN32)
+    struct stat st;
+    return fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode);
+#else
+    (void)f;
+    return 1;
+#endif
+}
+
+// Valida las partidas de un archivo ("-" = entrada estándar).
+// Las tuberías y FIFO (o todo, con 'stream') se leen como entrada en vivo:
+// cada partida se valida y se escribe en cuanto llega su resultado.
+// 0 = éxito, -1 = error de lectura
+static int validate_file(const char *path, OutputFormat format, int stream,
+                         OutBuffer *out, ValidateTotals *totals) {
+    PGNReader reader;
+    int from_stdin = (strcmp(path, "-") == 0);
+    if (from_stdin) {
+        pgn_reader_init(&reader, stdin);
+    } else if ((stream ? pgn_reader_open(&reader, path)
+                       : pgn_reader_open_mmap(&reader, path)) != 0) {
+        fprintf(stderr, "No se puede abrir archivo PGN: %s\n", path);
+        return -1;
+    }
+    int live = !reader.map && (stream || !is_regular_file(reader.f));
+    pgn_reader_set_streaming(&reader, live);
+
+    PGNRawGame raw;
+    PGNGame game;
+    PGNGameError err;
+    GameReport report = { from_stdin ? "<stdin>" : path, 0, 0, &game, 0, &err };
+    int rc;
+
+    while ((rc = pgn_reader_next(&reader, &raw)) == 1) {
+        report.game++;
+        report.offset = raw.offset;
+        report.ok = (pgn_validate_game(&game, raw.tags, raw.movetext, &err) == 0);
+
+        if (format == FORMAT_JSONL) write_jsonl(out, &report);
+        else write_tsv(out, &report);
+        if (live) {
+            out_flush(out);
+            fflush(out->f);
+        }
+
+        totals->games++;
+        if (report.ok) {
+            totals->valid++;
+            totals->plies += game.move_count;
+        } else {
+            totals->invalid++;
+        }
+    }
+
+    pgn_reader_close(&reader);
+    if (rc < 0) {
+        fprintf(stderr, "Error de lectura en archivo PGN: %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static void validate_usage(void) {
+    fprintf(stderr, "Uso: chess validate [--format jsonl|tsv] [--stream] [archivo.pgn ... | -]\n");
+    fprintf(stderr, "  Escribe un registro por partida en la salida estándar; sin archivos\n");
+    fprintf(stderr, "  (o con '-') lee de la entrada estándar\n");
+    fprintf(stderr, "  --stream  Entrada en vivo: cada partida se escribe al llegar su resultado\n");
+    fprintf(stderr, "            (automático con tuberías y FIFO)\n");
+}
+
+int validate_mode(int argc, char *argv[]) {
+    OutputFormat format = FORMAT_JSONL;
+    int stream = 0;
+    int first_file = argc;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "jsonl") == 0) {
+                format = FORMAT_JSONL;
+            } else if (strcmp(argv[i], "tsv") == 0) {
+                format = FORMAT_TSV;
+            } else {
+                validate_usage();
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream = 1;
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            validate_usage();
+            return 0;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            validate_usage();
+            return 2;
+        } else {
+            first_file = i;
+            break;
+        }
+    }
+
+    static OutBuffer out;
+    out.f = stdout;
+    out.len = 0;
+    if (format == FORMAT_TSV) {
+        out_str(&out, tsv_header);
+        if (stream) out_flush(&out);
+    }
+
+    ValidateTotals totals = { 0, 0, 0, 0 };
+    int read_errors = 0;
+    double t0 = now_seconds();
+
+    if (first_file >= argc) {
+        read_errors += (validate_file("-", format, stream, &out, &totals) != 0);
+    }
+    for (int i = first_file; i < argc; i++) {
+        read_errors += (validate_file(argv[i], format, stream, &out, &totals) != 0);
+    }
+    out_flush(&out);
+    fflush(stdout);
+
+    double elapsed = now_seconds() - t0;
+    fprintf(stderr, "%ld partidas: %ld válidas, %ld inválidas, %ld jugadas en %.2f s (%.0f partidas/s)\n",
+            totals.games, totals.valid, totals.invalid, totals.plies, elapsed,
+            elapsed > 0 ? (double)totals.games / elapsed : 0.0);
+
+    if (read_errors) return 2;
+    return totals.invalid ? 1 : 0;
+}
@@ -0,0 +1,18 @@
+// validate.h - Validación de archivos PGN sin interfaz (chess validate)
+//
+// Valida todas las partidas de uno o más archivos (o de la entrada
+// estándar) y escribe un registro por partida en JSON Lines o TSV, para
+// usar desde scripts. No hay menús ni mensajes por jugada: la salida se
+// acumula en un búfer y se escribe por bloques, salvo con entrada en vivo
+// (tuberías, FIFO o --stream): ahí cada partida se escribe en cuanto se lee
+// su resultado y la memoria solo depende de la partida más larga.
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+// Modo validate de la línea de comandos:
+//   chess validate [--format jsonl|tsv] [--stream] [archivo.pgn ... | -]
+// Retorna 0 si todas las partidas son válidas, 1 si alguna no lo es y 2
+// si hubo errores de uso o de lectura
+int validate_mode(int argc, char *argv[]);
+
+#endif // VALIDATE_H
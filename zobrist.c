@@ -0,0 +1,49 @@
+// zobrist.c - Generación de las claves Zobrist
+#include <pthread.h>
+#include "zobrist.h"
+
+uint64_t zobrist_piece[16][64];
+uint64_t zobrist_castling[16];
+uint64_t zobrist_en_passant[8];
+uint64_t zobrist_side;
+
+static pthread_once_t zobrist_once = PTHREAD_ONCE_INIT;
+
+// splitmix64: claves fijas entre ejecuciones (sirven para cachés en disco)
+static uint64_t next_key(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void zobrist_build(void)
+{
+    uint64_t state = 0x43484553535A4F42ULL;   // "CHESSZOB"
+
+    for (int color = 1; color <= 2; ++color) {
+        for (int type = 1; type <= 6; ++type) {
+            for (int sq = 0; sq < 64; ++sq) {
+                ZOBRIST_PIECE(color << 3 | type, sq) = next_key(&state);
+            }
+        }
+    }
+
+    // Cada derecho de enroque tiene su clave; la de un conjunto es el XOR
+    uint64_t right[4];
+    for (int i = 0; i < 4; ++i) right[i] = next_key(&state);
+    for (int bits = 0; bits < 16; ++bits) {
+        zobrist_castling[bits] = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (bits & (1 << i)) zobrist_castling[bits] ^= right[i];
+        }
+    }
+
+    for (int f = 0; f < 8; ++f) zobrist_en_passant[f] = next_key(&state);
+    zobrist_side = next_key(&state);
+}
+
+void zobrist_init(void)
+{
+    pthread_once(&zobrist_once, zobrist_build);
+}
@@ -0,0 +1,26 @@
+// zobrist.h - Claves Zobrist de 64 bits para identificar posiciones
+//
+// La clave de una posición es el XOR de una clave por (pieza, casilla), la
+// clave de los derechos de enroque, la columna de en passant (solo si el
+// bando al que le toca puede capturar al paso) y la del turno si juegan las
+// negras. Dos posiciones iguales tienen la misma clave; dos distintas
+// coinciden con probabilidad despreciable.
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+
+// [código de Board.squares & 15][casilla]: blancas 9..14, negras 1..6.
+// Las filas que no corresponden a ninguna pieza valen 0
+extern uint64_t zobrist_piece[16][64];
+#define ZOBRIST_PIECE(code, sq) (zobrist_piece[(code) & 15][(sq)])
+// [derechos empaquetados: 1 = blanco corto, 2 = blanco largo, 4 = negro corto, 8 = negro largo]
+extern uint64_t zobrist_castling[16];
+extern uint64_t zobrist_en_passant[8];   // [columna]
+extern uint64_t zobrist_side;            // juegan las negras
+
+// Genera las claves (idempotente). Se puede llamar desde varios hilos a la
+// vez: solo la primera llamada las genera y las demás esperan a que termine.
+void zobrist_init(void);
+
+#endif // ZOBRIST_H